@@ -0,0 +1,245 @@
+#include "algorithm.h"
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// Keyboard layer (CubeState::layerIndex) and whether the standard turn's
+// clockwise is the keyboard's clockwise (+1) or the opposite (-1)
+struct LayerTurn {
+    int layer;
+    int sign;
+};
+
+struct TurnSpec {
+    char letter;
+    int count;
+    LayerTurn layers[3];
+};
+
+// Outer turns, slices, wide turns and rotations. Keyboard layers: 0 L, 1 C,
+// 2 X (x axis); 3 D, 4 M, 5 U (y axis); 6 B, 7 S, 8 F (z axis)
+const TurnSpec turnSpecs[] = {
+    {'R', 1, {{2, 1}}},
+    {'L', 1, {{0, -1}}},
+    {'M', 1, {{1, -1}}},
+    {'U', 1, {{5, -1}}},
+    {'D', 1, {{3, 1}}},
+    {'E', 1, {{4, 1}}},
+    {'F', 1, {{8, 1}}},
+    {'B', 1, {{6, -1}}},
+    {'S', 1, {{7, 1}}},
+    {'r', 2, {{2, 1}, {1, 1}}},
+    {'l', 2, {{0, -1}, {1, -1}}},
+    {'u', 2, {{5, -1}, {4, -1}}},
+    {'d', 2, {{3, 1}, {4, 1}}},
+    {'f', 2, {{8, 1}, {7, 1}}},
+    {'b', 2, {{6, -1}, {7, -1}}},
+    {'x', 3, {{0, 1}, {1, 1}, {2, 1}}},
+    {'y', 3, {{3, -1}, {4, -1}, {5, -1}}},
+    {'z', 3, {{6, 1}, {7, 1}, {8, 1}}}
+};
+
+const int MAX_NESTING = 64;
+
+// A parsed part of an algorithm: its expansion and its gather
+struct Piece {
+    uint8_t gather[CubeState::FACELET_COUNT];
+    std::vector<uint8_t> moves;
+
+    Piece() {
+        for (int i = 0; i < CubeState::FACELET_COUNT; i++) gather[i] = (uint8_t)i;
+    }
+
+    // Follow this piece with a gather: facelet i takes what was at next[i]
+    void then(const uint8_t* next) {
+        uint8_t combined[CubeState::FACELET_COUNT];
+        for (int i = 0; i < CubeState::FACELET_COUNT; i++) combined[i] = gather[next[i]];
+        memcpy(gather, combined, sizeof(gather));
+    }
+
+    void then(const Piece& next) {
+        then(next.gather);
+        moves.insert(moves.end(), next.moves.begin(), next.moves.end());
+    }
+
+    void addMove(int move) {
+        then(CubeState::moveTable(move));
+        moves.push_back((uint8_t)move);
+    }
+
+    void invert() {
+        uint8_t inverse[CubeState::FACELET_COUNT];
+        for (int i = 0; i < CubeState::FACELET_COUNT; i++) inverse[gather[i]] = (uint8_t)i;
+        memcpy(gather, inverse, sizeof(gather));
+        std::vector<uint8_t> reversed(moves.rbegin(), moves.rend());
+        for (size_t i = 0; i < reversed.size(); i++) reversed[i] = (uint8_t)CubeState::inverseMove(reversed[i]);
+        moves.swap(reversed);
+    }
+};
+
+class Parser {
+public:
+    Parser(const char* text, size_t length) : begin(text), cursor(text), end(text + length) {}
+
+    // Whole input; false at the first error (column())
+    bool parse(Piece& result) {
+        if (!sequence(result, 0)) return false;
+        skipSpace();
+        return cursor == end;  // a stray ')' stops the sequence early
+    }
+
+    int column() const { return (int)(cursor - begin) + 1; }
+
+private:
+    const char* begin;
+    const char* cursor;
+    const char* end;
+
+    void skipSpace() {
+        while (cursor < end && isspace((unsigned char)*cursor)) cursor++;
+    }
+
+    // Items up to the end or a ')'
+    bool sequence(Piece& result, int depth) {
+        for (;;) {
+            skipSpace();
+            if (cursor == end || *cursor == ')') return true;
+
+            Piece item;
+            if (*cursor == '(') {
+                if (depth >= MAX_NESTING) return false;
+                cursor++;
+                if (!sequence(item, depth + 1)) return false;
+                if (cursor == end || *cursor != ')') return false;
+                cursor++;
+                if (!repeat(item)) return false;
+            } else if (!turn(item)) {
+                return false;
+            }
+            if (result.moves.size() + item.moves.size() > Algorithm::MAX_MOVES) return false;
+            result.then(item);
+        }
+    }
+
+    // Optional count and prime, in either order (R2', R'2)
+    bool suffix(long& count, bool& prime) {
+        count = 1;
+        prime = false;
+        if (cursor < end && *cursor == '\'') {
+            prime = true;
+            cursor++;
+        }
+        if (cursor < end && isdigit((unsigned char)*cursor)) {
+            count = 0;
+            while (cursor < end && isdigit((unsigned char)*cursor)) {
+                count = count * 10 + (*cursor - '0');
+                if (count > (long)Algorithm::MAX_MOVES) return false;
+                cursor++;
+            }
+        }
+        if (!prime && cursor < end && *cursor == '\'') {
+            prime = true;
+            cursor++;
+        }
+        return true;
+    }
+
+    bool turn(Piece& result) {
+        const TurnSpec* spec = nullptr;
+        for (size_t i = 0; i < sizeof(turnSpecs) / sizeof(turnSpecs[0]); i++) {
+            if (turnSpecs[i].letter == *cursor) spec = &turnSpecs[i];
+        }
+        if (!spec) return false;
+        cursor++;
+
+        // Uw is u
+        if (cursor < end && *cursor == 'w' && spec->count == 1 && strchr("RLUDFB", spec->letter)) {
+            char wide = (char)tolower(spec->letter);
+            for (size_t i = 0; i < sizeof(turnSpecs) / sizeof(turnSpecs[0]); i++) {
+                if (turnSpecs[i].letter == wide) spec = &turnSpecs[i];
+            }
+            cursor++;
+        }
+
+        long count;
+        bool prime;
+        if (!suffix(count, prime)) return false;
+        int quarters = (int)(count % 4);
+        if (prime) quarters = (4 - quarters) % 4;
+
+        for (int i = 0; i < spec->count; i++) {
+            int keyboardQuarters = spec->layers[i].sign > 0 ? quarters : (4 - quarters) % 4;
+            if (keyboardQuarters != 0) {
+                result.addMove(spec->layers[i].layer * 3 + keyboardQuarters - 1);
+            }
+        }
+        return true;
+    }
+
+    // Group count and prime: the group count times, inverted for a prime
+    bool repeat(Piece& group) {
+        long count;
+        bool prime;
+        if (!suffix(count, prime)) return false;
+        if (prime) group.invert();
+        if ((size_t)count * group.moves.size() > Algorithm::MAX_MOVES) return false;
+
+        Piece repeated;
+        for (long i = 0; i < count; i++) {
+            repeated.moves.insert(repeated.moves.end(), group.moves.begin(), group.moves.end());
+        }
+        // Gather to the power count by squaring
+        Piece power = group;
+        for (long n = count; n > 0; n >>= 1) {
+            if (n & 1) repeated.then(power.gather);
+            uint8_t square[CubeState::FACELET_COUNT];
+            memcpy(square, power.gather, sizeof(square));
+            power.then(square);
+        }
+        group.moves.swap(repeated.moves);
+        memcpy(group.gather, repeated.gather, sizeof(group.gather));
+        return true;
+    }
+};
+
+} // namespace
+
+const size_t Algorithm::MAX_MOVES;
+
+Algorithm::Algorithm() : movedCount(0) {
+    for (int i = 0; i < CubeState::FACELET_COUNT; i++) gather[i] = (uint8_t)i;
+}
+
+bool Algorithm::compile(const char* text, size_t length, int* errorColumn) {
+    Parser parser(text, length);
+    Piece result;
+    if (!parser.parse(result)) {
+        if (errorColumn) *errorColumn = parser.column();
+        return false;
+    }
+    memcpy(gather, result.gather, sizeof(gather));
+    moves.swap(result.moves);
+    updateMoved();
+    return true;
+}
+
+void Algorithm::updateMoved() {
+    movedCount = 0;
+    for (int i = 0; i < CubeState::FACELET_COUNT; i++) {
+        if (gather[i] != i) moved[movedCount++] = (uint8_t)i;
+    }
+}
+
+AlgorithmCache::AlgorithmCache(size_t maxEntries) : capacity(maxEntries > 0 ? maxEntries : 1) {
+}
+
+const Algorithm* AlgorithmCache::get(const std::string& text, int* errorColumn) {
+    std::unordered_map<std::string, Algorithm>::const_iterator found = entries.find(text);
+    if (found != entries.end()) return &found->second;
+
+    Algorithm algorithm;
+    if (!algorithm.compile(text.data(), text.size(), errorColumn)) return nullptr;
+    if (entries.size() >= capacity) entries.clear();
+    return &(entries[text] = algorithm);
+}
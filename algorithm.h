@@ -0,0 +1,67 @@
+#ifndef ALGORITHM_H
+#define ALGORITHM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cube_state.h"
+
+// A move sequence in standard (Singmaster) notation, compiled into the
+// CubeState moves it expands to and into one 54-facelet gather, so applying
+// it to a state costs one move however long it is.
+//
+// Notation: outer turns U D L R F B, slices M (as L) E (as D) S (as F), wide
+// turns u d l r f b or Uw ... Bw, whole-cube rotations x (as R) y (as U)
+// z (as F). A turn or a parenthesised group takes a count and/or a prime:
+// R2, R', R2', (R U R' U')6, (R U)'. Whitespace is optional.
+//
+// Standard turns map onto the keyboard layers (CubeState moves): R is X,
+// L is L', M is C', U is U', D is D, E is M, F is F, B is B', S is S, since
+// the keyboard's clockwise follows the renderer's axes rather than the face.
+class Algorithm {
+public:
+    // Longest expansion accepted, so (R U)999999999 fails instead of
+    // filling memory
+    static const size_t MAX_MOVES = 1 << 20;
+
+    Algorithm();
+
+    // Parse text; on failure returns false and sets errorColumn (1-based)
+    bool compile(const char* text, size_t length, int* errorColumn = nullptr);
+
+    // The expansion as CubeState moves, in order (for animation or a journal)
+    const std::vector<uint8_t>& getMoves() const { return moves; }
+
+    // After apply, facelet i holds the old facelet table()[i]
+    const uint8_t* table() const { return gather; }
+
+    void apply(CubeState& state) const { state.permute(gather, moved, movedCount); }
+
+private:
+    uint8_t gather[CubeState::FACELET_COUNT];
+    uint8_t moved[CubeState::FACELET_COUNT];
+    int movedCount;
+    std::vector<uint8_t> moves;
+
+    void updateMoved();
+};
+
+// Compiled algorithms by their exact text. Not thread-safe: one per thread.
+class AlgorithmCache {
+public:
+    explicit AlgorithmCache(size_t capacity = 4096);
+
+    // The compiled algorithm, or null (and errorColumn set) if text does not
+    // parse. Pointers stay valid until the cache fills and is emptied.
+    const Algorithm* get(const std::string& text, int* errorColumn = nullptr);
+
+    size_t size() const { return entries.size(); }
+
+private:
+    size_t capacity;
+    std::unordered_map<std::string, Algorithm> entries;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "async_solver.h"
+#include <chrono>
+#include <vector>
+#include "kociemba_solver.h"
+#include "optimal_solver.h"
+
+AsyncSolver* asyncSolver = nullptr;
+
+namespace {
+
+double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+const int AsyncSolver::SOLVED;
+const int AsyncSolver::FAILED;
+
+AsyncSolver::AsyncSolver() : cancelled(false), running(false), active(false), method(TWO_PHASE), startTime(0.0) {
+}
+
+AsyncSolver::~AsyncSolver() {
+    cancel();
+    if (worker.joinable()) worker.join();
+}
+
+bool AsyncSolver::start(const CubeState& state, Method solveMethod) {
+    if (running.load()) return false;
+    if (worker.joinable()) worker.join();  // already returned
+
+    // Nothing produces now, so the queue and figures can be reset
+    events.clear();
+    cancelled = false;
+    searchProgress.depth = 0;
+    searchProgress.nodes = 0;
+    searchProgress.building = nullptr;
+    method = solveMethod;
+    startTime = now();
+    active = true;
+
+    // Solvers are created here, on the thread that owns them; their tables
+    // load on the worker
+    if (method == OPTIMAL && !optimalSolver) optimalSolver = new OptimalSolver();
+    if (method == TWO_PHASE && !kociembaSolver) kociembaSolver = new KociembaSolver();
+
+    running = true;
+    worker = std::thread(&AsyncSolver::run, this, state);
+    return true;
+}
+
+void AsyncSolver::cancel() {
+    cancelled = true;
+    active = false;
+}
+
+void AsyncSolver::wait() {
+    if (worker.joinable()) worker.join();
+}
+
+bool AsyncSolver::poll(int& event) {
+    if (!active) return false;
+    int8_t next;
+    if (!events.pop(next)) return false;
+    event = next;
+    if (event < 0) active = false;
+    return true;
+}
+
+double AsyncSolver::elapsed() const {
+    return now() - startTime;
+}
+
+void AsyncSolver::send(int8_t event) {
+    // The queue holds any solution; waiting only happens if it somehow fills
+    while (!events.push(event)) {
+        if (cancelled.load(std::memory_order_relaxed)) return;
+        std::this_thread::yield();
+    }
+}
+
+void AsyncSolver::run(CubeState state) {
+    std::vector<int> solution;
+    bool solved;
+    if (method == OPTIMAL) {
+        OptimalSolver::Options options;
+        options.cancel = &cancelled;
+        options.progress = &searchProgress;
+        solved = optimalSolver->init("optimal_tables.bin", &cancelled, &searchProgress) &&
+                 optimalSolver->solve(state, solution, options);
+    } else {
+        KociembaSolver::Options options;
+        options.cancel = &cancelled;
+        options.progress = &searchProgress;
+        solved = kociembaSolver->init("kociemba_tables.bin") && kociembaSolver->solve(state, solution, options);
+    }
+
+    if (!cancelled.load()) {
+        for (size_t i = 0; solved && i < solution.size(); i++) {
+            send((int8_t)solution[i]);
+        }
+        send(solved ? SOLVED : FAILED);
+    }
+    running = false;
+}
@@ -0,0 +1,69 @@
+#ifndef ASYNC_SOLVER_H
+#define ASYNC_SOLVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "cube_state.h"
+#include "solver_progress.h"
+#include "spsc_queue.h"
+
+// Runs a solver on a worker thread so the window keeps drawing while it
+// searches. start() takes a snapshot of the state; the worker loads the
+// solver's tables (building them on the very first run), solves with a cancel
+// flag and live progress, then sends the solution's moves and a final SOLVED
+// or FAILED event through a lock-free single-producer/single-consumer queue.
+// The GLUT thread drains it each frame with poll(), so neither side locks.
+//
+// cancel() stops the search at its next check (every 4096 nodes), or a table
+// build within one block of entries, and makes poll() drop whatever the worker
+// still sends. All calls but the worker's
+// own come from one thread.
+class AsyncSolver {
+public:
+    enum Method { OPTIMAL, TWO_PHASE };
+
+    // Events besides CubeState moves (0..MOVE_COUNT-1)
+    static const int SOLVED = -1;  // every move of the solution has been sent
+    static const int FAILED = -2;  // no solution, or not a valid cube
+
+    AsyncSolver();
+    ~AsyncSolver();  // cancels and waits for the worker
+
+    // False if the last solve's worker has not finished (e.g. still stopping
+    // after a cancel, or building tables)
+    bool start(const CubeState& state, Method method);
+    void cancel();
+
+    // Block until the worker has returned and sent everything
+    void wait();
+
+    // Started and its SOLVED or FAILED event not yet polled, nor cancelled
+    bool isActive() const { return active; }
+    Method getMethod() const { return method; }
+
+    // Next event, if one is waiting
+    bool poll(int& event);
+
+    // Live figures of the running solve, and seconds since start()
+    const SolverProgress& progress() const { return searchProgress; }
+    double elapsed() const;
+
+private:
+    SpscQueue<int8_t, 64> events;  // a solution is at most 30 moves
+    std::thread worker;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> running;    // worker has not returned
+    bool active;
+    Method method;
+    double startTime;
+    SolverProgress searchProgress;
+
+    void run(CubeState state);
+    void send(int8_t event);
+};
+
+// Background solver of the window, created on first use
+extern AsyncSolver* asyncSolver;
+
+#endif
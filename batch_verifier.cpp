@@ -0,0 +1,323 @@
+#include "batch_verifier.h"
+#include "algorithm.h"
+#include "cube_state.h"
+#include "cube_symmetry.h"
+#include "transposition_table.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Input is read and handed to the workers in blocks of whole lines
+const size_t BLOCK_SIZE = 1 << 20;
+const size_t BLOCKS_PER_THREAD = 4;
+
+// Final states remembered for --duplicates (16 bytes each)
+const size_t SEEN_STATES = 1 << 22;
+
+const char colorLetter[6] = {'W', 'Y', 'R', 'O', 'B', 'G'};
+const char hexDigit[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+
+struct Block {
+    size_t id;
+    string text;
+    string output;
+    size_t lines;
+    size_t duplicates;
+};
+
+// Bounded queue of blocks waiting for a worker
+class BlockQueue {
+private:
+    mutex lock;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    deque<Block> blocks;
+    size_t capacity;
+    bool closed;
+
+public:
+    explicit BlockQueue(size_t cap) : capacity(cap), closed(false) {}
+
+    void push(Block& block) {
+        unique_lock<mutex> guard(lock);
+        notFull.wait(guard, [this]() { return blocks.size() < capacity; });
+        blocks.push_back(Block());
+        blocks.back().id = block.id;
+        blocks.back().text.swap(block.text);
+        notEmpty.notify_one();
+    }
+
+    bool pop(Block& block) {
+        unique_lock<mutex> guard(lock);
+        notEmpty.wait(guard, [this]() { return !blocks.empty() || closed; });
+        if (blocks.empty()) return false;
+        block.id = blocks.front().id;
+        block.text.swap(blocks.front().text);
+        blocks.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+// Finished blocks, written out strictly in input order. Only capacity blocks
+// past the one being waited for may be held, so a slow output or one slow
+// block stops the workers instead of letting the finished output pile up.
+class OrderedWriter {
+private:
+    mutex lock;
+    condition_variable ready;
+    condition_variable notFull;
+    map<size_t, string> finished;
+    size_t nextId;
+    size_t capacity;
+    bool done;
+    FILE* out;
+
+public:
+    OrderedWriter(FILE* file, size_t cap) : nextId(0), capacity(cap), done(false), out(file) {}
+
+    void submit(size_t id, string& output) {
+        unique_lock<mutex> guard(lock);
+        notFull.wait(guard, [this, id]() { return id < nextId + capacity; });
+        finished[id].swap(output);
+        ready.notify_one();
+    }
+
+    void finish() {
+        lock_guard<mutex> guard(lock);
+        done = true;
+        ready.notify_one();
+    }
+
+    void run() {
+        unique_lock<mutex> guard(lock);
+        for (;;) {
+            ready.wait(guard, [this]() { return finished.count(nextId) > 0 || (done && finished.empty()); });
+            if (finished.empty()) break;
+            string output;
+            output.swap(finished[nextId]);
+            finished.erase(nextId);
+            guard.unlock();
+            fwrite(output.data(), 1, output.size(), out);
+            guard.lock();
+            nextId++;
+            notFull.notify_all();
+        }
+        fflush(out);
+    }
+};
+
+void appendResult(string& output, const CubeState& state) {
+    char line[16 + 1 + 8 + 1 + 54 + 1];
+    char* p = line;
+    uint64_t h = state.hash();
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        *p++ = hexDigit[(h >> shift) & 0xF];
+    }
+    *p++ = ' ';
+    const char* status = state.isSolved() ? "solved" : "unsolved";
+    size_t statusLength = strlen(status);
+    memcpy(p, status, statusLength);
+    p += statusLength;
+    *p++ = ' ';
+    for (int i = 0; i < CubeState::FACELET_COUNT; i++) {
+        *p++ = colorLetter[state.facelet(i)];
+    }
+    *p++ = '\n';
+    output.append(line, p - line);
+}
+
+// seen is shared by all workers; a state counts as a duplicate if any earlier
+// processed line ended in it (two identical lines verified at the same moment
+// may both miss, and a full table forgets old states). With symmetric, states
+// equal up to a whole-cube rotation or reflection count as the same. With an
+// algorithm cache the lines are standard notation, each applied as one
+// compiled gather.
+void verifyBlock(Block& block, TranspositionTable* seen, bool symmetric, AlgorithmCache* algorithms) {
+    block.output.clear();
+    block.output.reserve(block.text.size() + 4096);
+    block.lines = 0;
+    block.duplicates = 0;
+
+    const char* cursor = block.text.data();
+    const char* end = cursor + block.text.size();
+    while (cursor < end) {
+        const char* lineEnd = (const char*)memchr(cursor, '\n', end - cursor);
+        if (!lineEnd) lineEnd = end;
+
+        CubeState state;
+        const char* text = cursor;
+        bool valid = true;
+        if (algorithms) {
+            int column = 0;
+            const Algorithm* algorithm = algorithms->get(string(cursor, lineEnd), &column);
+            if (algorithm) {
+                algorithm->apply(state);
+            } else {
+                valid = false;
+                text = cursor + column - 1;
+            }
+        } else {
+            for (;;) {
+                int move = CubeState::parseMove(text, lineEnd);
+                if (move < 0) {
+                    valid = text >= lineEnd;
+                    break;
+                }
+                state.applyMove(move);
+            }
+        }
+
+        if (valid) {
+            appendResult(block.output, state);
+            if (seen) {
+                uint64_t key = symmetric ? CubeSymmetry::canonical(state).hash() : state.hash();
+                uint64_t found;
+                if (seen->probe(key, found)) {
+                    block.duplicates++;
+                } else {
+                    seen->store(key, 1);
+                }
+            }
+        } else {
+            char message[64];
+            int length = snprintf(message, sizeof(message), "- error column %d\n", (int)(text - cursor) + 1);
+            block.output.append(message, length);
+        }
+        block.lines++;
+        cursor = lineEnd + 1;
+    }
+}
+
+} // namespace
+
+int runBatchVerifier(int argc, char** argv) {
+    const char* path = nullptr;
+    int threads = 0;
+    bool duplicates = false;
+    bool symmetric = false;
+    bool standard = false;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--duplicates") == 0) {
+            duplicates = true;
+        } else if (strcmp(argv[i], "--symmetry") == 0) {
+            duplicates = true;
+            symmetric = true;
+        } else if (strcmp(argv[i], "--notation") == 0 && i + 1 < argc) {
+            const char* notation = argv[++i];
+            if (strcmp(notation, "standard") != 0 && strcmp(notation, "keyboard") != 0) {
+                fprintf(stderr, "Unknown notation %s (keyboard or standard)\n", notation);
+                return 1;
+            }
+            standard = strcmp(notation, "standard") == 0;
+        } else if (strcmp(argv[i], "-") != 0) {
+            path = argv[i];
+        }
+    }
+    if (threads <= 0) {
+        threads = (int)thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+    }
+
+    FILE* in = path ? fopen(path, "rb") : stdin;
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+
+    auto startTime = chrono::steady_clock::now();
+    BlockQueue queue(threads * BLOCKS_PER_THREAD);
+    OrderedWriter writer(stdout, threads * BLOCKS_PER_THREAD);
+    size_t totalLines = 0;
+    size_t totalDuplicates = 0;
+    mutex countLock;
+    unique_ptr<TranspositionTable> seen(duplicates ? new TranspositionTable(SEEN_STATES) : nullptr);
+
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&]() {
+            Block block;
+            size_t lines = 0;
+            size_t repeats = 0;
+            AlgorithmCache algorithms;
+            while (queue.pop(block)) {
+                verifyBlock(block, seen.get(), symmetric, standard ? &algorithms : nullptr);
+                lines += block.lines;
+                repeats += block.duplicates;
+                writer.submit(block.id, block.output);
+            }
+            lock_guard<mutex> guard(countLock);
+            totalLines += lines;
+            totalDuplicates += repeats;
+        }));
+    }
+    thread writerThread([&]() { writer.run(); });
+
+    // Read fixed-size chunks; a partial last line is carried into the next block
+    vector<char> buffer(BLOCK_SIZE);
+    string carry;
+    size_t nextId = 0;
+    for (;;) {
+        size_t count = fread(buffer.data(), 1, buffer.size(), in);
+        if (count == 0) break;
+
+        size_t lastNewline = count;
+        while (lastNewline > 0 && buffer[lastNewline - 1] != '\n') lastNewline--;
+        if (lastNewline == 0) {
+            carry.append(buffer.data(), count);
+            continue;
+        }
+
+        Block block;
+        block.id = nextId++;
+        block.text.swap(carry);
+        block.text.append(buffer.data(), lastNewline);
+        carry.assign(buffer.data() + lastNewline, count - lastNewline);
+        queue.push(block);
+    }
+    if (!carry.empty()) {
+        Block block;
+        block.id = nextId++;
+        block.text.swap(carry);
+        block.text.push_back('\n');
+        queue.push(block);
+    }
+    if (in != stdin) fclose(in);
+
+    queue.close();
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    writer.finish();
+    writerThread.join();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    fprintf(stderr, "Verified %zu sequences in %.3f s (%.0f sequences/s, %d threads)\n",
+            totalLines, seconds, seconds > 0 ? totalLines / seconds : 0.0, threads);
+    if (duplicates) {
+        fprintf(stderr, "%zu sequences repeat an earlier final state%s\n", totalDuplicates,
+                symmetric ? " up to symmetry" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef BATCH_VERIFIER_H
+#define BATCH_VERIFIER_H
+
+// Headless batch mode: streams move sequences (one per line, keyboard
+// notation as in CubeState::moveName) from a file or stdin, applies each to a
+// fresh solved cube on a pool of worker threads and writes one line per input
+// line, in input order:
+//
+//   <state hash> <solved|unsolved> <54 facelet colours>
+//
+// --duplicates counts lines whose final state an earlier line already reached
+// (shared lock-free TranspositionTable); --symmetry does the same up to the 48
+// cube symmetries. The count goes to stderr with the throughput.
+//
+// --notation standard reads Singmaster notation instead (see Algorithm); each
+// worker caches compiled lines, so a repeated algorithm is parsed once and
+// applied as a single gather.
+//
+// Usage: rubiks_cube --verify [file|-] [--threads N] [--duplicates | --symmetry]
+//                    [--notation keyboard|standard]
+int runBatchVerifier(int argc, char** argv);
+
+#endif
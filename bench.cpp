@@ -0,0 +1,222 @@
+// Headless move-throughput benchmark.
+// Applies long random move sequences through RubiksCube::rotateLayer and the
+// CubeState engine, the same moves applied to a batch of 4096 states at once
+// (CubeBatch, counted per state), times random layer turns on a 100x100x100
+// cube, then prints the results as JSON on stdout.
+//
+// Usage: cube_bench [moves] [seed]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "cube.h"
+#include "cube_state.h"
+#include "cube_batch.h"
+
+// Global allocation counter so we can report heap allocations per move
+static std::atomic<unsigned long long> allocationCount(0);
+
+void* operator new(size_t size) {
+    allocationCount++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    allocationCount++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+// Kept out of line so GCC does not pair the inlined free() with operator new
+__attribute__((noinline)) static void releaseBlock(void* p) { free(p); }
+
+void operator delete(void* p) noexcept { releaseBlock(p); }
+void operator delete[](void* p) noexcept { releaseBlock(p); }
+void operator delete(void* p, size_t) noexcept { releaseBlock(p); }
+void operator delete[](void* p, size_t) noexcept { releaseBlock(p); }
+
+struct BenchResult {
+    std::string name;
+    unsigned long long moves;
+    double seconds;
+    unsigned long long allocations;
+    unsigned checksum;
+};
+
+// Fold a state into a number so the work cannot be optimised away
+static unsigned stateChecksum(const CubeState& state) {
+    unsigned sum = 0;
+    for (int i = 0; i < CubeState::FACELET_COUNT; i++) {
+        sum = sum * 31 + state.facelet(i);
+    }
+    return sum;
+}
+
+static BenchResult benchRotateLayer(const std::vector<uint8_t>& moves) {
+    RubiksCube cube;
+    point3f origins[3][3] = {
+        {cube.leftOrigin, cube.centerOrigin, cube.rightOrigin},
+        {cube.bottomOrigin, cube.middleOrigin, cube.topOrigin},
+        {cube.backOrigin, point3f(0.0f, 0.0f, 0.0f), cube.frontOrigin}
+    };
+
+    unsigned long long allocationsBefore = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < moves.size(); i++) {
+        int axis = CubeState::moveAxis(moves[i]);
+        int offset = CubeState::moveOffset(moves[i]);
+        cube.rotateLayer(origins[axis][offset + 1], axis, CubeState::moveTurn(moves[i]) == 0);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    BenchResult result;
+    result.name = "rubiks_cube_rotate_layer";
+    result.moves = moves.size();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.allocations = allocationCount - allocationsBefore;
+    result.checksum = stateChecksum(cube.getState());
+    return result;
+}
+
+static BenchResult benchCubeState(const std::vector<uint8_t>& moves) {
+    CubeState state;
+
+    unsigned long long allocationsBefore = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    state.applyMoves(moves.data(), moves.size());
+    auto end = std::chrono::steady_clock::now();
+
+    BenchResult result;
+    result.name = "cube_state_apply_move";
+    result.moves = moves.size();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.allocations = allocationCount - allocationsBefore;
+    result.checksum = stateChecksum(state);
+    return result;
+}
+
+// The move list split over a batch of scrambled states: every state gets
+// moves / batchSize moves, so "moves" counts state-moves like the loops above
+static BenchResult benchCubeBatch(const std::vector<uint8_t>& moves, size_t batchSize, unsigned seed) {
+    CubeBatch batch(batchSize);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> moveDist(0, CubeState::MOVE_COUNT - 1);
+    for (size_t i = 0; i < batchSize; i++) {
+        CubeState state;
+        for (int k = 0; k < 20; k++) {
+            state.applyMove(moveDist(rng));
+        }
+        batch.setState(i, state);
+    }
+    size_t movesPerState = moves.size() / batchSize;
+    if (movesPerState == 0) movesPerState = 1;
+
+    unsigned long long allocationsBefore = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    batch.applyMoves(moves.data(), movesPerState);
+    auto end = std::chrono::steady_clock::now();
+
+    unsigned sum = 0;
+    for (size_t i = 0; i < batchSize; i++) {
+        sum = sum * 31 + stateChecksum(batch.getState(i));
+    }
+
+    BenchResult result;
+    result.name = std::string("cube_batch_apply_move_") + CubeBatch::kernelName();
+    result.moves = (unsigned long long)movesPerState * batchSize;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.allocations = allocationCount - allocationsBefore;
+    result.checksum = sum;
+    return result;
+}
+
+// Random layer turns (any layer, any direction) on a large NxN cube
+static BenchResult benchLargeCube(int size, unsigned seed, unsigned long long turns) {
+    RubiksCube cube(size);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> axisDist(0, 2);
+    std::uniform_int_distribution<int> layerDist(0, size - 1);
+    std::uniform_int_distribution<int> turnDist(0, 2);
+    std::vector<uint8_t> moves(turns * 3);
+    for (size_t i = 0; i < moves.size(); i += 3) {
+        moves[i] = (uint8_t)axisDist(rng);
+        moves[i + 1] = (uint8_t)layerDist(rng);
+        moves[i + 2] = (uint8_t)turnDist(rng);
+    }
+
+    unsigned long long allocationsBefore = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < moves.size(); i += 3) {
+        cube.turnLayer(moves[i], moves[i + 1], moves[i + 2]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    const NxNCubeState& state = cube.getCube();
+    unsigned sum = 0;
+    for (int i = 0; i < state.faceletCount(); i++) {
+        sum = sum * 31 + state.facelet(i);
+    }
+
+    BenchResult result;
+    result.name = "nxn_" + std::to_string(size) + "_turn_layer";
+    result.moves = turns;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.allocations = allocationCount - allocationsBefore;
+    result.checksum = sum;
+    return result;
+}
+
+static void printResult(const BenchResult& r, bool last) {
+    double seconds = r.seconds > 0.0 ? r.seconds : 1e-12;
+    printf("    {\"name\": \"%s\", \"moves\": %llu, \"seconds\": %.6f, "
+           "\"moves_per_sec\": %.1f, \"ns_per_move\": %.3f, "
+           "\"allocs_per_move\": %.4f, \"checksum\": %u}%s\n",
+           r.name.c_str(), r.moves, r.seconds,
+           r.moves / seconds, seconds * 1e9 / r.moves,
+           (double)r.allocations / r.moves, r.checksum, last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+    unsigned long long moveCount = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000ULL;
+    unsigned seed = argc > 2 ? (unsigned)strtoul(argv[2], nullptr, 10) : 12345u;
+    if (moveCount == 0) moveCount = 1;
+
+    // Quarter turns only, the same moves the keyboard can produce
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> layerDist(0, CubeState::LAYER_COUNT - 1);
+    std::uniform_int_distribution<int> dirDist(0, 1);
+    std::vector<uint8_t> moves(moveCount);
+    for (size_t i = 0; i < moves.size(); i++) {
+        moves[i] = (uint8_t)(layerDist(rng) * 3 + dirDist(rng) * 2);
+    }
+
+    std::vector<BenchResult> results;
+    results.push_back(benchRotateLayer(moves));
+    results.push_back(benchCubeState(moves));
+    results.push_back(benchCubeBatch(moves, 4096, seed));
+    results.push_back(benchLargeCube(100, seed, 20000));
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("{\n");
+    printf("  \"moves\": %llu,\n", moveCount);
+    printf("  \"seed\": %u,\n", seed);
+    printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        printResult(results[i], i + 1 == results.size());
+    }
+    printf("  ],\n");
+    printf("  \"peak_rss_kb\": %ld\n", usage.ru_maxrss);
+    printf("}\n");
+    return 0;
+}
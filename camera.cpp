@@ -5,13 +5,21 @@
 Camera* camera = nullptr;
 
 Camera::Camera() {
-    distance = 12.0f;         // Start at a good viewing distance
+    homeDistance = 12.0f;
+    maxDistance = 50.0f;
+    fieldOfView = 45.0f;
+    viewportWidth = 800;
+    viewportHeight = 600;
+    changes = 1;
+    matrixChanges = 0;
+    distance = homeDistance;  // Start at a good viewing distance
     azimuth = 45.0f;         // Start at 45 degrees horizontally
     elevation = 30.0f;       // Start looking down slightly
     target = point3f(0.0f, 0.0f, 0.0f);  // Look at cube center
 }
 
 void Camera::orbit(float deltaAzimuth, float deltaElevation) {
+    changes++;
     // Update rotation angles
     azimuth += deltaAzimuth;
     elevation += deltaElevation;
@@ -26,44 +34,164 @@ void Camera::orbit(float deltaAzimuth, float deltaElevation) {
 }
 
 void Camera::zoom(float deltaDistance) {
+    changes++;
     distance += deltaDistance;
     
     // Clamp distance to reasonable bounds
     if (distance < 2.0f) distance = 2.0f;     // Minimum distance
-    if (distance > 50.0f) distance = 50.0f;   // Maximum distance
+    if (distance > maxDistance) distance = maxDistance;   // Maximum distance
 }
 
-void Camera::apply() {
+void Camera::viewBasis(point3f& eye, point3f& forward, point3f& right, point3f& up) const {
     // Convert spherical coordinates to cartesian coordinates
     float radAzimuth = azimuth * M_PI / 180.0f;
     float radElevation = elevation * M_PI / 180.0f;
     
     // Calculate eye position using spherical coordinates
-    float eyeX = target.x + distance * cos(radElevation) * cos(radAzimuth);
-    float eyeY = target.y + distance * sin(radElevation);
-    float eyeZ = target.z + distance * cos(radElevation) * sin(radAzimuth);
+    eye.x = target.x + distance * cos(radElevation) * cos(radAzimuth);
+    eye.y = target.y + distance * sin(radElevation);
+    eye.z = target.z + distance * cos(radElevation) * sin(radAzimuth);
+
+    // Same basis gluLookAt builds with Y up
+    forward = point3f(-cos(radElevation) * cos(radAzimuth), -sin(radElevation), -cos(radElevation) * sin(radAzimuth));
+    right = point3f(-forward.z, 0.0f, forward.x);
+    float length = sqrt(right.x * right.x + right.z * right.z);
+    right.x /= length;
+    right.z /= length;
+    up = point3f(right.y * forward.z - right.z * forward.y,
+                 right.z * forward.x - right.x * forward.z,
+                 right.x * forward.y - right.y * forward.x);
+}
+
+void Camera::apply() {
+    point3f eye, forward, right, up;
+    viewBasis(eye, forward, right, up);
     
-    // Apply the camera transformation
-    gluLookAt(eyeX, eyeY, eyeZ,              // Eye position
-              target.x, target.y, target.z,  // Look at target
-              0.0f, 1.0f, 0.0f);             // Up vector (Y is up)
+    // Apply the camera transformation from the same basis the picking ray
+    // and the core-profile matrices use
+    gluLookAt(eye.x, eye.y, eye.z,                                        // Eye position
+              eye.x + forward.x, eye.y + forward.y, eye.z + forward.z,    // One unit ahead
+              up.x, up.y, up.z);                                          // Camera up
 }
 
 void Camera::reset() {
-    distance = 12.0f;
+    changes++;
+    distance = homeDistance;
     azimuth = 45.0f;
     elevation = 30.0f;
     target = point3f(0.0f, 0.0f, 0.0f);
 }
 
 void Camera::setTarget(float x, float y, float z) {
+    changes++;
     target.x = x;
     target.y = y;
     target.z = z;
 }
 
 void Camera::setDistance(float dist) {
+    changes++;
     distance = dist;
     if (distance < 2.0f) distance = 2.0f;
-    if (distance > 50.0f) distance = 50.0f;
+    if (distance > maxDistance) distance = maxDistance;
+}
+
+// Scale the start and maximum distance to a cube of the given width
+void Camera::fitToSize(float width) {
+    changes++;
+    homeDistance = width > 3.3f ? 12.0f * width / 3.3f : 12.0f;
+    maxDistance = homeDistance * 4.0f > 50.0f ? homeDistance * 4.0f : 50.0f;
+    distance = homeDistance;
+}
+
+void Camera::setViewport(int width, int height) {
+    changes++;
+    viewportWidth = width > 0 ? width : 1;
+    viewportHeight = height > 0 ? height : 1;
+}
+
+void Camera::pickRay(int x, int y, point3f& origin, point3f& direction) const {
+    point3f forward, right, up;
+    viewBasis(origin, forward, right, up);
+
+    // Pixel centre in normalized device coordinates, scaled to the view frustum
+    float tanHalf = tan(fieldOfView * 0.5f * M_PI / 180.0f);
+    float aspect = (float)viewportWidth / viewportHeight;
+    float u = (2.0f * (x + 0.5f) / viewportWidth - 1.0f) * tanHalf * aspect;
+    float v = (1.0f - 2.0f * (y + 0.5f) / viewportHeight) * tanHalf;
+    direction = point3f(forward.x + right.x * u + up.x * v,
+                        forward.y + right.y * u + up.y * v,
+                        forward.z + right.z * u + up.z * v);
+}
+
+bool Camera::project(const point3f& point, float& x, float& y) const {
+    point3f eye, forward, right, up;
+    viewBasis(eye, forward, right, up);
+    point3f d(point.x - eye.x, point.y - eye.y, point.z - eye.z);
+    float depth = d.x * forward.x + d.y * forward.y + d.z * forward.z;
+    if (depth <= 0.0f) return false;
+
+    float tanHalf = tan(fieldOfView * 0.5f * M_PI / 180.0f);
+    float aspect = (float)viewportWidth / viewportHeight;
+    float u = (d.x * right.x + d.y * right.y + d.z * right.z) / (depth * tanHalf * aspect);
+    float v = (d.x * up.x + d.y * up.y + d.z * up.z) / (depth * tanHalf);
+    x = (u + 1.0f) * 0.5f * viewportWidth;
+    y = (1.0f - v) * 0.5f * viewportHeight;
+    return true;
+}
+
+// Same matrices gluLookAt and the gluPerspective call in reshape build
+void Camera::updateMatrices() const {
+    point3f eye, forward, right, up;
+    viewBasis(eye, forward, right, up);
+    float view[16] = {
+        right.x, up.x, -forward.x, 0.0f,
+        right.y, up.y, -forward.y, 0.0f,
+        right.z, up.z, -forward.z, 0.0f,
+        -(right.x * eye.x + right.y * eye.y + right.z * eye.z),
+        -(up.x * eye.x + up.y * eye.y + up.z * eye.z),
+        forward.x * eye.x + forward.y * eye.y + forward.z * eye.z,
+        1.0f
+    };
+
+    float nearPlane = 1.0f;
+    float farPlane = getFarPlane();
+    float f = 1.0f / tan(fieldOfView * 0.5f * M_PI / 180.0f);
+    float aspect = (float)viewportWidth / viewportHeight;
+    float projection[16] = {
+        f / aspect, 0.0f, 0.0f, 0.0f,
+        0.0f, f, 0.0f, 0.0f,
+        0.0f, 0.0f, (farPlane + nearPlane) / (nearPlane - farPlane), -1.0f,
+        0.0f, 0.0f, 2.0f * farPlane * nearPlane / (nearPlane - farPlane), 0.0f
+    };
+
+    for (int i = 0; i < 16; i++) {
+        viewMatrix[i] = view[i];
+        projectionMatrix[i] = projection[i];
+    }
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += projection[k * 4 + row] * view[column * 4 + k];
+            }
+            viewProjectionMatrix[column * 4 + row] = sum;
+        }
+    }
+    matrixChanges = changes;
+}
+
+const float* Camera::getViewMatrix() const {
+    if (matrixChanges != changes) updateMatrices();
+    return viewMatrix;
+}
+
+const float* Camera::getProjectionMatrix() const {
+    if (matrixChanges != changes) updateMatrices();
+    return projectionMatrix;
+}
+
+const float* Camera::getViewProjectionMatrix() const {
+    if (matrixChanges != changes) updateMatrices();
+    return viewProjectionMatrix;
 }
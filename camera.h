@@ -21,6 +21,23 @@ private:
     float azimuth;       // Horizontal rotation (around Y axis) in degrees
     float elevation;     // Vertical rotation (up/down) in degrees
     point3f target;      // What we're looking at (cube center)
+    float homeDistance;  // Distance after a reset
+    float maxDistance;   // Zoom-out limit
+    float fieldOfView;   // Vertical, in degrees, as passed to gluPerspective
+    int viewportWidth;   // Set by reshape, for picking
+    int viewportHeight;
+
+    // View and projection matrices (column-major) for the shader path,
+    // rebuilt only after the camera changed
+    unsigned changes;    // bumped by every setter
+    mutable unsigned matrixChanges;
+    mutable float viewMatrix[16];
+    mutable float projectionMatrix[16];
+    mutable float viewProjectionMatrix[16];
+    void updateMatrices() const;
+
+    // Eye position and view basis (forward, right and up unit vectors)
+    void viewBasis(point3f& eye, point3f& forward, point3f& right, point3f& up) const;
 
 public:
     Camera();
@@ -33,6 +50,13 @@ public:
     
     // Getters for debugging
     float getDistance() const { return distance; }
+    float getMaxDistance() const { return maxDistance; }
+    float getFieldOfView() const { return fieldOfView; }
+    float getFarPlane() const { return maxDistance * 2.0f; }
+    unsigned getChanges() const { return changes; }
+    const float* getViewMatrix() const;
+    const float* getProjectionMatrix() const;
+    const float* getViewProjectionMatrix() const;  // projection * view
     float getAzimuth() const { return azimuth; }
     float getElevation() const { return elevation; }
     point3f getTarget() const { return target; }
@@ -40,6 +64,14 @@ public:
     // Setters
     void setTarget(float x, float y, float z);
     void setDistance(float dist);
+    void fitToSize(float width);
+    void setViewport(int width, int height);
+
+    // Picking: the world-space ray through window pixel (x, y) (y down, as
+    // GLUT reports it) and the window position of a world point, both from
+    // the spherical parameters and the perspective set up in reshape
+    void pickRay(int x, int y, point3f& origin, point3f& direction) const;
+    bool project(const point3f& point, float& x, float& y) const;
 };
 
 // Global camera instance
@@ -1,6 +1,8 @@
 #include "cube.h"
+#include "shader_pipeline.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -8,252 +10,68 @@
 
 RubiksCube* rubiksCube = nullptr;
 
-// Color RGB values for each face
-float colors[6][3] = {
-    {1.0f, 1.0f, 1.0f},  // WHITE
-    {1.0f, 1.0f, 0.0f},  // YELLOW
-    {1.0f, 0.0f, 0.0f},  // RED
-    {1.0f, 0.5f, 0.0f},  // ORANGE
-    {0.0f, 0.0f, 1.0f},  // BLUE
-    {0.0f, 1.0f, 0.0f}   // GREEN
-};
-
-// Cubie implementation
-Cubie::Cubie(float px, float py, float pz) : position{px, py, pz} {
-    
-    colors[0] = WHITE;  
-    colors[1] = YELLOW;  
-    colors[2] = RED;     
-    colors[3] = ORANGE;  
-    colors[4] = BLUE;    
-    colors[5] = GREEN;   
-}
-
-
-// Updates the face colors based on rotation
-void Cubie::rotateFaceColors(int axis, bool clockwise) {
-    int temp[6];
-    for (int i = 0; i < 6; i++) {
-        temp[i] = colors[i];
-    }
-    
-    switch (axis) {
-        case 0: // X-axis rotation 
-            if (clockwise) {
-                // Front->Top, Top->Back, Back->Bottom, Bottom->Front
-                colors[4] = temp[0]; 
-                colors[1] = temp[4]; 
-                colors[5] = temp[1]; 
-                colors[0] = temp[5]; 
-            } else {
-                // Front->Bottom, Bottom->Back, Back->Top, Top->Front
-                colors[5] = temp[0];
-                colors[1] = temp[5];
-                colors[4] = temp[1];
-                colors[0] = temp[4];
-            }
-            break;
-            
-        case 1: // Y-axis rotation
-            if (clockwise) {
-                // Front->Right, Right->Back, Back->Left, Left->Front
-                colors[3] = temp[0]; 
-                colors[1] = temp[3];
-                colors[2] = temp[1];
-                colors[0] = temp[2];
-            } else {
-                // Front->Left, Left->Back, Back->Right, Right->Front
-                colors[2] = temp[0]; 
-                colors[1] = temp[2]; 
-                colors[3] = temp[1]; 
-                colors[0] = temp[3]; 
-            }
-            break;
-            
-        case 2: // Z-axis rotation
-            if (clockwise) {
-                // Left->Top, Top->Right, Right->Bottom, Bottom->Left
-                colors[4] = temp[2]; 
-                colors[3] = temp[4]; 
-                colors[5] = temp[3]; 
-                colors[2] = temp[5]; 
-            } else {
-                // Left->Bottom, Bottom->Right, Right->Top, Top->Left
-                colors[5] = temp[2];
-                colors[3] = temp[5];
-                colors[4] = temp[3];
-                colors[2] = temp[4];
-            }
-            break;
-    }
-}
-
-
-
-void Cubie::draw() {
-    glPushMatrix();
-    glTranslatef(this->position.x, this->position.y, this->position.z);
-    
-    // Draw cube faces
-    glBegin(GL_QUADS);
-    
-    // Front face (z = 0.5)
-    if (colors[0] != -1) {
-        glColor3fv(::colors[colors[0]]);
-        glNormal3f(0.0f, 0.0f, 1.0f);
-        glVertex3f(-0.5f, -0.5f, 0.5f);
-        glVertex3f(0.5f, -0.5f, 0.5f);
-        glVertex3f(0.5f, 0.5f, 0.5f);
-        glVertex3f(-0.5f, 0.5f, 0.5f);
-    }
-    
-    // Back face (z = -0.5)
-    if (colors[1] != -1) {
-        glColor3fv(::colors[colors[1]]);
-        glNormal3f(0.0f, 0.0f, -1.0f);
-        glVertex3f(-0.5f, -0.5f, -0.5f);
-        glVertex3f(-0.5f, 0.5f, -0.5f);
-        glVertex3f(0.5f, 0.5f, -0.5f);
-        glVertex3f(0.5f, -0.5f, -0.5f);
-    }
-    
-    // Left face (x = -0.5)
-    if (colors[2] != -1) {
-        glColor3fv(::colors[colors[2]]);
-        glNormal3f(-1.0f, 0.0f, 0.0f);
-        glVertex3f(-0.5f, -0.5f, -0.5f);
-        glVertex3f(-0.5f, 0.5f, -0.5f);
-        glVertex3f(-0.5f, 0.5f, 0.5f);
-        glVertex3f(-0.5f, -0.5f, 0.5f);
-    }
-    
-    // Right face (x = 0.5)
-    if (colors[3] != -1) {
-        glColor3fv(::colors[colors[3]]);
-        glNormal3f(1.0f, 0.0f, 0.0f);
-        glVertex3f(0.5f, -0.5f, -0.5f);
-        glVertex3f(0.5f, -0.5f, 0.5f);
-        glVertex3f(0.5f, 0.5f, 0.5f);
-        glVertex3f(0.5f, 0.5f, -0.5f);
-    }
-    
-    // Top face (y = 0.5)
-    if (colors[4] != -1) {
-        glColor3fv(::colors[colors[4]]);
-        glNormal3f(0.0f, 1.0f, 0.0f);
-        glVertex3f(-0.5f, 0.5f, -0.5f);
-        glVertex3f(-0.5f, 0.5f, 0.5f);
-        glVertex3f(0.5f, 0.5f, 0.5f);
-        glVertex3f(0.5f, 0.5f, -0.5f);
-    }
-    
-    // Bottom face (y = -0.5)
-    if (colors[5] != -1) {
-        glColor3fv(::colors[colors[5]]);
-        glNormal3f(0.0f, -1.0f, 0.0f);
-        glVertex3f(-0.5f, -0.5f, -0.5f);
-        glVertex3f(0.5f, -0.5f, -0.5f);
-        glVertex3f(0.5f, -0.5f, 0.5f);
-        glVertex3f(-0.5f, -0.5f, 0.5f);
-    }
-    
-    glEnd();
-    
-    // Draw black edges
-    glColor3f(0.0f, 0.0f, 0.0f);
-    glLineWidth(5.0f);
-    glBegin(GL_LINES);
-    
-    // Draw cube edges
-    // Bottom face edges
-    glVertex3f(-0.5f, -0.5f, -0.5f); glVertex3f(0.5f, -0.5f, -0.5f);
-    glVertex3f(0.5f, -0.5f, -0.5f); glVertex3f(0.5f, -0.5f, 0.5f);
-    glVertex3f(0.5f, -0.5f, 0.5f); glVertex3f(-0.5f, -0.5f, 0.5f);
-    glVertex3f(-0.5f, -0.5f, 0.5f); glVertex3f(-0.5f, -0.5f, -0.5f);
-    
-    // Top face edges
-    glVertex3f(-0.5f, 0.5f, -0.5f); glVertex3f(0.5f, 0.5f, -0.5f);
-    glVertex3f(0.5f, 0.5f, -0.5f); glVertex3f(0.5f, 0.5f, 0.5f);
-    glVertex3f(0.5f, 0.5f, 0.5f); glVertex3f(-0.5f, 0.5f, 0.5f);
-    glVertex3f(-0.5f, 0.5f, 0.5f); glVertex3f(-0.5f, 0.5f, -0.5f);
-    
-    // Vertical edges
-    glVertex3f(-0.5f, -0.5f, -0.5f); glVertex3f(-0.5f, 0.5f, -0.5f);
-    glVertex3f(0.5f, -0.5f, -0.5f); glVertex3f(0.5f, 0.5f, -0.5f);
-    glVertex3f(0.5f, -0.5f, 0.5f); glVertex3f(0.5f, 0.5f, 0.5f);
-    glVertex3f(-0.5f, -0.5f, 0.5f); glVertex3f(-0.5f, 0.5f, 0.5f);
-    
-    glEnd();
-    
-    glPopMatrix();
-}
-
 // RubiksCube implementation
-RubiksCube::RubiksCube() {
+RubiksCube::RubiksCube(int size) : state(size), colorsDirty(true) {
+    dirtyLayers.reserve(MAX_DIRTY_LAYERS);
     initializeCube();
 }
 
 RubiksCube::~RubiksCube() {
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            for (int k = 0; k < 3; k++) {
-                delete cube[i][j][k];
-            }
-        }
-    }
 }
 
 void RubiksCube::initializeCube() {
-    cube.resize(3);
-    for (int i = 0; i < 3; i++) {
-        cube[i].resize(3);
-        for (int j = 0; j < 3; j++) {
-            cube[i][j].resize(3);
-            for (int k = 0; k < 3; k++) {
-                float x = (i - 1) * 1.1f;
-                float y = (j - 1) * 1.1f;
-                float z = (k - 1) * 1.1f;
-                cube[i][j][k] = new Cubie(x, y, z);
-            }
+    // Outer layers sit (N - 1) / 2 layers from the centre; on even cubes the
+    // middle keys turn the layer just above/right of/in front of the centre
+    float outer = (state.size() - 1) * 0.5f;
+    float middle = state.size() % 2 == 0 ? 0.5f : 0.0f;
+    topOrigin = point3f(0.0f, outer, 0.0f);
+    middleOrigin = point3f(0.0f, middle, 0.0f);
+    bottomOrigin = point3f(0.0f, -outer, 0.0f);
+    leftOrigin = point3f(-outer, 0.0f, 0.0f);
+    centerOrigin = point3f(middle, 0.0f, 0.0f);
+    rightOrigin = point3f(outer, 0.0f, 0.0f);
+    frontOrigin = point3f(0.0f, 0.0f, outer);
+    backOrigin = point3f(0.0f, 0.0f, -outer);
+    sliceOrigin = point3f(0.0f, 0.0f, middle);
+    state.reset();
+    renderer.build(state.size(), cubieSpacing());
+    colorsDirty = true;
+}
+
+// Layer index (0..N-1) of an origin along the rotation axis
+int RubiksCube::layerIndex(point3f origin, int axis) const {
+    float value = axis == 0 ? origin.x : (axis == 1 ? origin.y : origin.z);
+    int layer = (int)floor(value + (state.size() - 1) * 0.5f + 0.5f);
+    if (layer < 0) layer = 0;
+    if (layer > state.size() - 1) layer = state.size() - 1;
+    return layer;
+}
+
+// Push state changes to the renderer's colour buffer, only for the turned
+// layers when there are few of them
+void RubiksCube::syncColors() {
+    if (colorsDirty) {
+        renderer.updateColors(state);
+    } else {
+        for (size_t i = 0; i < dirtyLayers.size(); i++) {
+            renderer.updateLayerColors(state, dirtyLayers[i] / state.size(), dirtyLayers[i] % state.size());
         }
     }
+    colorsDirty = false;
+    dirtyLayers.clear();
 }
 
 void RubiksCube::draw() {
     extern LayerAnimation currentAnimation;
+
+    syncColors();
     
     if (currentAnimation.active) {
         // Draw non-rotating cubies normally
-        float tolerance = 0.6f;
-        
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                for (int k = 0; k < 3; k++) {
-                    if (cube[i][j][k] != nullptr) {
-                        Cubie* cubie = cube[i][j][k];
-                        bool inLayer = false;
-                        
-                        // Check if cubie is in the animated layer
-                        switch (currentAnimation.axis) {
-                            case 0: // X-axis rotation
-                                inLayer = (fabs(cubie->position.x - currentAnimation.origin.x) < tolerance);
-                                break;
-                            case 1: // Y-axis rotation
-                                inLayer = (fabs(cubie->position.y - currentAnimation.origin.y) < tolerance);
-                                break;
-                            case 2: // Z-axis rotation
-                                inLayer = (fabs(cubie->position.z - currentAnimation.origin.z) < tolerance);
-                                break;
-                        }
-                        
-                        // Draw cubie normally if it's not in the animated layer
-                        if (!inLayer) {
-                            cubie->draw();
-                        }
-                    }
-                }
-            }
-        }
+        int layer = layerIndex(currentAnimation.origin, currentAnimation.axis);
+        renderer.drawExceptLayer(currentAnimation.axis, layer);
+        renderer.drawInteriorCap(currentAnimation.axis, layer - 1, 1);
+        renderer.drawInteriorCap(currentAnimation.axis, layer + 1, -1);
         
         // Draw the animated layer with corrected angle direction for each axis
         float angle;
@@ -274,173 +92,86 @@ void RubiksCube::draw() {
         drawAnimatedLayer(currentAnimation.origin, currentAnimation.axis, angle);
     } else {
         // No animation - draw all cubies normally
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                for (int k = 0; k < 3; k++) {
-                    if (cube[i][j][k] != nullptr) {
-                        cube[i][j][k]->draw();
-                    }
-                }
-            }
-        }
+        renderer.drawAll();
     }
 }
 
 void RubiksCube::rotateLayer(point3f origin, int axis, bool clockwise) {
-    // Find all cubies that belong to this layer
-    std::vector<Cubie*> layerCubies;
-    std::vector<point3f> oldPositions;
-    
-    float tolerance = 0.6f; // Tolerance for position matching
-    
-    // Collect cubies in the layer based on the origin and axis
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            for (int k = 0; k < 3; k++) {
-                Cubie* cubie = cube[i][j][k];
-                bool inLayer = false;
-                
-                // Check if cubie is in the layer based on axis
-                switch (axis) {
-                    case 0: // X-axis rotation (around vertical line through origin)
-                        if (fabs(cubie->position.x - origin.x) < tolerance) {
-                            inLayer = true;
-                        }
-                        break;
-                    case 1: // Y-axis rotation (around horizontal line through origin)  
-                        if (fabs(cubie->position.y - origin.y) < tolerance) {
-                            inLayer = true;
-                        }
-                        break;
-                    case 2: // Z-axis rotation (around front-back line through origin)
-                        if (fabs(cubie->position.z - origin.z) < tolerance) {
-                            inLayer = true;
-                        }
-                        break;
-                }
-                
-                if (inLayer) {
-                    layerCubies.push_back(cubie);
-                    oldPositions.push_back(cubie->position);
-                }
-            }
-        }
-    }
-    
-    // Rotate each cubie's position around the origin
-    for (size_t i = 0; i < layerCubies.size(); i++) {
-        Cubie* cubie = layerCubies[i];
-        point3f pos = oldPositions[i];
-        
-        // Translate to origin
-        pos.x -= origin.x;
-        pos.y -= origin.y;
-        pos.z -= origin.z;
-        
-        // Apply rotation based on axis
-        point3f newPos = pos;
-        float angle = clockwise ? -M_PI/2 : M_PI/2; // 90 degrees
-        
-        switch (axis) {
-            case 0: // Rotate around X-axis
-                newPos.y = pos.y * cos(angle) - pos.z * sin(angle);
-                newPos.z = pos.y * sin(angle) + pos.z * cos(angle);
-                break;
-            case 1: // Rotate around Y-axis
-                newPos.x = pos.x * cos(angle) + pos.z * sin(angle);
-                newPos.z = -pos.x * sin(angle) + pos.z * cos(angle);
-                break;
-            case 2: // Rotate around Z-axis
-                newPos.x = pos.x * cos(angle) - pos.y * sin(angle);
-                newPos.y = pos.x * sin(angle) + pos.y * cos(angle);
-                break;
+    turnLayer(axis, layerIndex(origin, axis), clockwise ? 0 : 2);
+}
+
+// Turn layer 0..N-1 along axis: turn 0 = clockwise, 1 = half turn, 2 = counter-clockwise
+void RubiksCube::turnLayer(int axis, int layer, int turn) {
+    state.turnLayer(axis, layer, turn);
+    if (!colorsDirty) {
+        if (dirtyLayers.size() < MAX_DIRTY_LAYERS) {
+            dirtyLayers.push_back(axis * state.size() + layer);
+        } else {
+            colorsDirty = true;
         }
-        
-        // Translate back from origin
-        newPos.x += origin.x;
-        newPos.y += origin.y;
-        newPos.z += origin.z;
-        
-        // Round to nearest grid position to avoid floating point errors
-        newPos.x = round(newPos.x / 1.1f) * 1.1f;
-        newPos.y = round(newPos.y / 1.1f) * 1.1f;
-        newPos.z = round(newPos.z / 1.1f) * 1.1f;
-        
-        cubie->position = newPos;
-        
-        // IMPORTANT: Rotate the face colors with the cubie's physical rotation
-        cubie->rotateFaceColors(axis, clockwise);
     }
-    
-    // Update the cube array to reflect new positions
-    std::vector<std::vector<std::vector<Cubie*>>> newCube(3);
-    for (int i = 0; i < 3; i++) {
-        newCube[i].resize(3);
-        for (int j = 0; j < 3; j++) {
-            newCube[i][j].resize(3);
-            for (int k = 0; k < 3; k++) {
-                newCube[i][j][k] = nullptr;
-            }
-        }
+}
+
+// Apply a CubeState move; on other sizes it turns the same outer or middle layer as its key
+void RubiksCube::applyMove(int move) {
+    int axis = CubeState::moveAxis(move);
+    turnLayer(axis, layerIndex(moveOrigin(move), axis), CubeState::moveTurn(move));
+}
+
+// Origin of layer 0..N-1 along axis, as passed to rotateLayer
+point3f RubiksCube::layerOrigin(int axis, int layer) const {
+    float value = layer - (state.size() - 1) * 0.5f;
+    switch (axis) {
+        case 0: return point3f(value, 0.0f, 0.0f);
+        case 1: return point3f(0.0f, value, 0.0f);
+        case 2: return point3f(0.0f, 0.0f, value);
     }
-    
-    // Place all cubies in their new positions
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            for (int k = 0; k < 3; k++) {
-                if (cube[i][j][k] != nullptr) {
-                    Cubie* cubie = cube[i][j][k];
-                    // Calculate new array indices based on position
-                    int newI = (int)round(cubie->position.x / 1.1f) + 1;
-                    int newJ = (int)round(cubie->position.y / 1.1f) + 1;
-                    int newK = (int)round(cubie->position.z / 1.1f) + 1;
-                    
-                    // Bounds checking
-                    if (newI >= 0 && newI < 3 && newJ >= 0 && newJ < 3 && newK >= 0 && newK < 3) {
-                        newCube[newI][newJ][newK] = cubie;
-                    }
-                }
-            }
-        }
+    return point3f(0.0f, 0.0f, 0.0f);
+}
+
+// Origin of the layer a CubeState move turns (one of the named origins)
+point3f RubiksCube::moveOrigin(int move) const {
+    int offset = CubeState::moveOffset(move);
+    switch (CubeState::moveAxis(move)) {
+        case 0: return offset < 0 ? leftOrigin : (offset > 0 ? rightOrigin : centerOrigin);
+        case 1: return offset < 0 ? bottomOrigin : (offset > 0 ? topOrigin : middleOrigin);
+        case 2: return offset < 0 ? backOrigin : (offset > 0 ? frontOrigin : sliceOrigin);
     }
-    
-    // Update the main cube array
-    cube = newCube;
+    return point3f(0.0f, 0.0f, 0.0f);
+}
+
+CubeState RubiksCube::getState() const {
+    CubeState result;
+    state.toCubeState(result);
+    return result;
+}
+
+void RubiksCube::setState(const CubeState& newState) {
+    state.fromCubeState(newState);
+    colorsDirty = true;
+}
+
+void RubiksCube::setCube(const NxNCubeState& newState) {
+    if (newState.size() != state.size()) return;
+    state = newState;
+    colorsDirty = true;
 }
 
 void RubiksCube::drawAnimatedLayer(point3f origin, int axis, float angle) {
-    // Find all cubies that belong to this layer
-    std::vector<Cubie*> layerCubies;
-    float tolerance = 0.6f;
-    
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            for (int k = 0; k < 3; k++) {
-                if (cube[i][j][k] != nullptr) {
-                    Cubie* cubie = cube[i][j][k];
-                    bool inLayer = false;
-                    
-                    // Check if cubie is in the layer based on axis
-                    switch (axis) {
-                        case 0: // X-axis rotation (around vertical line through origin)
-                            inLayer = (fabs(cubie->position.x - origin.x) < tolerance);
-                            break;
-                        case 1: // Y-axis rotation (around horizontal line through origin)
-                            inLayer = (fabs(cubie->position.y - origin.y) < tolerance);
-                            break;
-                        case 2: // Z-axis rotation (around depth line through origin)
-                            inLayer = (fabs(cubie->position.z - origin.z) < tolerance);
-                            break;
-                    }
-                    
-                    if (inLayer) {
-                        layerCubies.push_back(cubie);
-                    }
-                }
-            }
-        }
+    syncColors();
+    int layer = layerIndex(origin, axis);
+
+    // Core profile: the shader turns the layer about its axis (every layer
+    // origin lies on that axis through the cube centre)
+    if (shaderPipeline) {
+        shaderPipeline->setLayerTurn(axis, angle);
+        renderer.drawLayer(axis, layer);
+        renderer.drawInteriorCap(axis, layer, -1);
+        renderer.drawInteriorCap(axis, layer, 1);
+        shaderPipeline->setLayerTurn(axis, 0.0f);
+        return;
     }
-    
+
     // Draw the rotating layer with animation
     glPushMatrix();
     
@@ -464,36 +195,17 @@ void RubiksCube::drawAnimatedLayer(point3f origin, int axis, float angle) {
     glTranslatef(-origin.x, -origin.y, -origin.z);
     
     // Draw all cubies in the layer
-    for (Cubie* cubie : layerCubies) {
-        cubie->draw();
-    }
+    renderer.drawLayer(axis, layer);
+    renderer.drawInteriorCap(axis, layer, -1);
+    renderer.drawInteriorCap(axis, layer, 1);
     
     glPopMatrix();
 }
 
 void RubiksCube::resetCube() {
-    // Reset all cubies to their initial positions and colors
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            for (int k = 0; k < 3; k++) {
-                if (cube[i][j][k] != nullptr) {
-                    // Reset position to original grid position
-                    float x = (i - 1) * 1.1f;
-                    float y = (j - 1) * 1.1f;
-                    float z = (k - 1) * 1.1f;
-                    cube[i][j][k]->position = point3f(x, y, z);
-                    
-                    // Reset colors to initial solved state
-                    cube[i][j][k]->colors[0] = WHITE;   // Front
-                    cube[i][j][k]->colors[1] = YELLOW;  // Back
-                    cube[i][j][k]->colors[2] = RED;     // Left
-                    cube[i][j][k]->colors[3] = ORANGE;  // Right
-                    cube[i][j][k]->colors[4] = BLUE;    // Top
-                    cube[i][j][k]->colors[5] = GREEN;   // Bottom
-                }
-            }
-        }
-    }
+    // Back to the solved state
+    state.reset();
+    colorsDirty = true;
     
     // Also stop any active animation
     extern LayerAnimation currentAnimation;
@@ -502,3 +214,48 @@ void RubiksCube::resetCube() {
 }
 
 
+
+bool RubiksCube::pickSticker(const point3f& origin, const point3f& direction, StickerHit& hit) const {
+    int n = state.size();
+    float half = (n - 1) * 0.5f;
+    float extent = half * cubieSpacing() + 0.5f;
+    float o[3] = {origin.x, origin.y, origin.z};
+    float d[3] = {direction.x, direction.y, direction.z};
+
+    // Slab test; the entry face is on the axis whose slab is entered last
+    float nearest = -1e30f;
+    float farthest = 1e30f;
+    int entryAxis = -1;
+    for (int a = 0; a < 3; a++) {
+        if (fabs(d[a]) < 1e-12f) {
+            if (o[a] < -extent || o[a] > extent) return false;
+            continue;
+        }
+        float t0 = (-extent - o[a]) / d[a];
+        float t1 = (extent - o[a]) / d[a];
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > nearest) {
+            nearest = t0;
+            entryAxis = a;
+        }
+        if (t1 < farthest) farthest = t1;
+    }
+    if (entryAxis < 0 || nearest > farthest || nearest < 0.0f) return false;
+
+    float p[3];
+    for (int a = 0; a < 3; a++) {
+        p[a] = o[a] + d[a] * nearest;
+    }
+    int normal[3] = {0, 0, 0};
+    normal[entryAxis] = d[entryAxis] > 0.0f ? -1 : 1;
+    hit.face = CubeState::faceFromNormal(normal);
+    hit.point = point3f(p[0], p[1], p[2]);
+    for (int a = 0; a < 3; a++) {
+        int index = (int)floor(p[a] / cubieSpacing() + half + 0.5f);
+        if (index < 0) index = 0;
+        if (index > n - 1) index = n - 1;
+        hit.cubie[a] = index;
+    }
+    hit.cubie[entryAxis] = normal[entryAxis] > 0 ? n - 1 : 0;
+    return true;
+}
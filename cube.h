@@ -4,6 +4,9 @@
 #include <GL/glut.h>
 #include <vector>
 #include "camera.h"
+#include "cube_state.h"
+#include "nxn_cube_state.h"
+#include "cube_renderer.h"
 
 enum CubeColor
 {
@@ -15,56 +18,85 @@ enum CubeColor
     GREEN
 };
 
-// Small parts of the Rubik's cube
-struct Cubie
-{
-    point3f position;
-    int colors[6];
-
-    Cubie(float px, float py, float pz);
-    void draw();
-    void rotateFaceColors(int axis, bool clockwise); // Rotate which face each color is on
-};
-
 struct LayerAnimation {
     bool active;
     point3f origin;     
     int axis;           
+    int layer;          // 0..N-1 along axis
+    int turn;           // 0 = clockwise, 1 = half turn, 2 = counter-clockwise
     bool clockwise;     
     float currentAngle; 
     float targetAngle;
-    float speed;       
+    double startTime;   // animationClock() seconds when the turn started
+    double duration;    // seconds for the whole turn
     
-    LayerAnimation() : active(false), origin(0,0,0), axis(0), clockwise(true), 
-                      currentAngle(0), targetAngle(90), speed(3.0f) {}
+    LayerAnimation() : active(false), origin(0,0,0), axis(0), layer(0), turn(0), clockwise(true), 
+                      currentAngle(0), targetAngle(90), startTime(0.0), duration(0.5) {}
 };
 
-// Main Rubik's cube class
+// Sticker under a pick ray: the face it is on, the cubie it belongs to
+// (0..N-1 per axis) and the world-space point where the ray meets it
+struct StickerHit {
+    int face;
+    int cubie[3];
+    point3f point;
+};
+
+// Main Rubik's cube class, any size from 2x2 up to NxNCubeState::MAX_SIZE.
+// Only the stickers are stored; the renderer keeps the surface cubies in GPU buffers.
 class RubiksCube
 {
 private:
-    std::vector<std::vector<std::vector<Cubie *>>> cube;
+    static const size_t MAX_DIRTY_LAYERS = 16;  // beyond this a full refresh is cheaper
+
+    NxNCubeState state;
+    CubeRenderer renderer;
+    bool colorsDirty;               // every colour needs refreshing
+    std::vector<int> dirtyLayers;   // layers turned since the last draw, axis * N + layer
+
+    float cubieSpacing() const { return 1.1f; }
+    void syncColors();
 
 public:
-    RubiksCube();
+    RubiksCube(int size = 3);
     ~RubiksCube();
 
     void draw();
     void initializeCube();
     void resetCube();
+    int getSize() const { return state.size(); }
 
-    // Origins
-    point3f topOrigin = point3f(0.0f, 1.0f, 0.0f);
-    point3f middleOrigin = point3f(0.0f, 0.0f, 0.0f);
-    point3f bottomOrigin = point3f(0.0f, -1.0f, 0.0f);
-    point3f leftOrigin = point3f(-1.0f, 0.0f, 0.0f);
-    point3f centerOrigin = point3f(0.0f, 0.0f, 0.0f);
-    point3f rightOrigin = point3f(1.0f, 0.0f, 0.0f);
-    point3f frontOrigin = point3f(0.0f, 0.0f, 1.0f);
-    point3f backOrigin = point3f(0.0f, 0.0f, -1.0f);
+    // Origins, in layers from the cube centre (set by initializeCube)
+    point3f topOrigin;
+    point3f middleOrigin;
+    point3f bottomOrigin;
+    point3f leftOrigin;
+    point3f centerOrigin;
+    point3f rightOrigin;
+    point3f frontOrigin;
+    point3f backOrigin;
+    point3f sliceOrigin;
 
     void rotateLayer(point3f origin, int axis, bool clockwise);
+    void turnLayer(int axis, int layer, int turn);
+    void applyMove(int move);
+    point3f layerOrigin(int axis, int layer) const;
+    int layerIndex(point3f origin, int axis) const;
+    point3f moveOrigin(int move) const;
+    const NxNCubeState& getCube() const { return state; }
+    uint64_t getHash() const { return state.hash(); }  // kept up to date by every turn
+
+    // 3x3 state for the solvers and the move engine; other sizes return a solved cube
+    CubeState getState() const;
+    void setState(const CubeState& newState);
+    // Replace the stickers with a state of the same size (no animation)
+    void setCube(const NxNCubeState& newState);
     void drawAnimatedLayer(point3f origin, int axis, float angle);
+
+    // Ray test against the cube's bounding box, mapping the entry point onto
+    // the sticker grid of that face. O(1) at any size; direction need not be
+    // normalized. Returns false if the ray misses.
+    bool pickSticker(const point3f& origin, const point3f& direction, StickerHit& hit) const;
 };
 
 extern RubiksCube *rubiksCube;
@@ -0,0 +1,240 @@
+#include "cube_batch.h"
+#include "cube_symmetry.h"
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CUBE_BATCH_X86 1
+#endif
+
+namespace {
+
+const size_t VECTOR_BYTES = 32;
+
+// Facelet permutation of every move as cycles: after the move, row cycle[k]
+// holds what row cycle[k + 1] held (and the last holds what the first held)
+struct MoveCycles {
+    uint8_t rows[CubeState::MOVE_COUNT][CubeState::FACELET_COUNT]; // cycles back to back
+    uint8_t lengths[CubeState::MOVE_COUNT][CubeState::FACELET_COUNT];
+    int cycleCount[CubeState::MOVE_COUNT];
+
+    MoveCycles() {
+        for (int move = 0; move < CubeState::MOVE_COUNT; move++) {
+            const uint8_t* gather = CubeState::moveTable(move);
+            bool seen[CubeState::FACELET_COUNT] = {false};
+            int used = 0;
+            cycleCount[move] = 0;
+            for (int start = 0; start < CubeState::FACELET_COUNT; start++) {
+                if (seen[start] || gather[start] == start) continue;
+                int length = 0;
+                for (int i = start; !seen[i]; i = gather[i]) {
+                    seen[i] = true;
+                    rows[move][used + length++] = (uint8_t)i;
+                }
+                lengths[move][cycleCount[move]++] = (uint8_t)length;
+                used += length;
+            }
+        }
+    }
+};
+
+const MoveCycles& moveCycles() {
+    static const MoveCycles cycles;
+    return cycles;
+}
+
+// Rotate the rows of each cycle over columns [0, columns). Word is what the
+// kernel moves at once; load and store access one word.
+template <typename Word, typename Load, typename Store>
+void rotateCycles(uint8_t* rows, size_t stride, size_t columns, int move, Load load, Store store) {
+    const MoveCycles& cycles = moveCycles();
+    for (size_t column = 0; column < columns; column += sizeof(Word)) {
+        const uint8_t* cycle = cycles.rows[move];
+        for (int c = 0; c < cycles.cycleCount[move]; c++) {
+            int length = cycles.lengths[move][c];
+            Word first = load(rows + cycle[0] * stride + column);
+            for (int k = 0; k + 1 < length; k++) {
+                store(rows + cycle[k] * stride + column, load(rows + cycle[k + 1] * stride + column));
+            }
+            store(rows + cycle[length - 1] * stride + column, first);
+            cycle += length;
+        }
+    }
+}
+
+void applyScalar(uint8_t* rows, size_t stride, size_t columns, int move) {
+    rotateCycles<uint64_t>(rows, stride, columns, move,
+        [](const uint8_t* p) { uint64_t w; memcpy(&w, p, sizeof(w)); return w; },
+        [](uint8_t* p, uint64_t w) { memcpy(p, &w, sizeof(w)); });
+}
+
+#ifdef CUBE_BATCH_X86
+// SSE2 is part of every x86-64 CPU, so the template works as is
+void applySse2(uint8_t* rows, size_t stride, size_t columns, int move) {
+    rotateCycles<__m128i>(rows, stride, columns, move,
+        [](const uint8_t* p) { return _mm_load_si128((const __m128i*)p); },
+        [](uint8_t* p, __m128i w) { _mm_store_si128((__m128i*)p, w); });
+}
+
+// Same loop as rotateCycles, written out so every instruction is compiled for AVX2
+__attribute__((target("avx2")))
+void applyAvx2(uint8_t* rows, size_t stride, size_t columns, int move) {
+    const MoveCycles& cycles = moveCycles();
+    for (size_t column = 0; column < columns; column += sizeof(__m256i)) {
+        const uint8_t* cycle = cycles.rows[move];
+        for (int c = 0; c < cycles.cycleCount[move]; c++) {
+            int length = cycles.lengths[move][c];
+            __m256i first = _mm256_load_si256((const __m256i*)(rows + cycle[0] * stride + column));
+            for (int k = 0; k + 1 < length; k++) {
+                __m256i next = _mm256_load_si256((const __m256i*)(rows + cycle[k + 1] * stride + column));
+                _mm256_store_si256((__m256i*)(rows + cycle[k] * stride + column), next);
+            }
+            _mm256_store_si256((__m256i*)(rows + cycle[length - 1] * stride + column), first);
+            cycle += length;
+        }
+    }
+}
+#endif
+
+// Symmetry canonicalisation, one state at a time
+void canonicalizeScalar(uint8_t* rows, size_t stride, size_t columns) {
+    for (size_t column = 0; column < columns; column++) {
+        uint8_t facelets[CubeState::FACELET_COUNT];
+        for (int f = 0; f < CubeState::FACELET_COUNT; f++) {
+            facelets[f] = rows[f * stride + column];
+        }
+        CubeState state;
+        state.setFacelets(facelets);
+        CubeState canonical = CubeSymmetry::canonical(state);
+        for (int f = 0; f < CubeState::FACELET_COUNT; f++) {
+            rows[f * stride + column] = canonical.facelet(f);
+        }
+    }
+}
+
+#ifdef CUBE_BATCH_X86
+// Symmetry canonicalisation of 32 states at once. Each symmetry is a row
+// gather plus a byte shuffle for the colours; the rows are compared in order,
+// stopping once every state has decided between the candidate and its best.
+__attribute__((target("avx2")))
+void canonicalizeAvx2(uint8_t* rows, size_t stride, size_t columns) {
+    const int count = CubeState::FACELET_COUNT;
+    __m256i original[CubeState::FACELET_COUNT];
+    __m256i candidate[CubeState::FACELET_COUNT];
+    for (size_t column = 0; column < columns; column += sizeof(__m256i)) {
+        for (int f = 0; f < count; f++) {
+            original[f] = _mm256_load_si256((const __m256i*)(rows + f * stride + column));
+        }
+
+        for (int s = 1; s < CubeSymmetry::COUNT; s++) {
+            const uint8_t* source = CubeSymmetry::sourceFacelets(s);
+            uint8_t lut[16] = {0};
+            memcpy(lut, CubeSymmetry::colorMap(s), 6);
+            __m256i colors = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)lut));
+
+            __m256i undecided = _mm256_set1_epi8(-1);
+            __m256i less = _mm256_setzero_si256();
+            int f = 0;
+            while (f < count) {
+                candidate[f] = _mm256_shuffle_epi8(colors, original[source[f]]);
+                __m256i best = _mm256_load_si256((const __m256i*)(rows + f * stride + column));
+                __m256i lower = _mm256_cmpgt_epi8(best, candidate[f]);
+                __m256i higher = _mm256_cmpgt_epi8(candidate[f], best);
+                less = _mm256_or_si256(less, _mm256_and_si256(lower, undecided));
+                undecided = _mm256_andnot_si256(_mm256_or_si256(lower, higher), undecided);
+                f++;
+                if (_mm256_testz_si256(undecided, undecided)) break;
+            }
+            if (_mm256_testz_si256(less, less)) continue;
+
+            for (; f < count; f++) {
+                candidate[f] = _mm256_shuffle_epi8(colors, original[source[f]]);
+            }
+            for (f = 0; f < count; f++) {
+                __m256i* row = (__m256i*)(rows + f * stride + column);
+                _mm256_store_si256(row, _mm256_blendv_epi8(_mm256_load_si256(row), candidate[f], less));
+            }
+        }
+    }
+}
+#endif
+
+typedef void (*MoveKernel)(uint8_t*, size_t, size_t, int);
+typedef void (*CanonicalKernel)(uint8_t*, size_t, size_t);
+
+struct Kernel {
+    MoveKernel apply;
+    CanonicalKernel canonicalize;
+    const char* name;
+
+    Kernel() : apply(applyScalar), canonicalize(canonicalizeScalar), name("scalar") {
+#ifdef CUBE_BATCH_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            apply = applyAvx2;
+            canonicalize = canonicalizeAvx2;
+            name = "avx2";
+        } else if (__builtin_cpu_supports("sse2")) {
+            apply = applySse2;
+            name = "sse2";
+        }
+#endif
+    }
+};
+
+const Kernel& kernel() {
+    static const Kernel selected;
+    return selected;
+}
+
+} // namespace
+
+CubeBatch::CubeBatch(size_t count) : count(count) {
+    stride = (count + VECTOR_BYTES - 1) / VECTOR_BYTES * VECTOR_BYTES;
+    if (stride == 0) stride = VECTOR_BYTES;
+    storage.resize(CubeState::FACELET_COUNT * stride + VECTOR_BYTES);
+    uintptr_t base = (uintptr_t)storage.data();
+    rows = storage.data() + (VECTOR_BYTES - base % VECTOR_BYTES) % VECTOR_BYTES;
+
+    // Every state starts solved
+    CubeState solved;
+    for (int f = 0; f < CubeState::FACELET_COUNT; f++) {
+        memset(rows + f * stride, solved.facelet(f), stride);
+    }
+}
+
+void CubeBatch::applyMove(int move) {
+    kernel().apply(rows, stride, stride, move);
+}
+
+void CubeBatch::applyMoves(const uint8_t* moves, size_t moveCount) {
+    MoveKernel apply = kernel().apply;
+    for (size_t i = 0; i < moveCount; i++) {
+        apply(rows, stride, stride, moves[i]);
+    }
+}
+
+void CubeBatch::setState(size_t index, const CubeState& state) {
+    for (int f = 0; f < CubeState::FACELET_COUNT; f++) {
+        rows[f * stride + index] = state.facelet(f);
+    }
+}
+
+CubeState CubeBatch::getState(size_t index) const {
+    uint8_t colors[CubeState::FACELET_COUNT];
+    for (int f = 0; f < CubeState::FACELET_COUNT; f++) {
+        colors[f] = rows[f * stride + index];
+    }
+    CubeState state;
+    state.setFacelets(colors);
+    return state;
+}
+
+void CubeBatch::canonicalize() {
+    const Kernel& selected = kernel();
+    // The scalar kernel works per state, so it skips the padding columns
+    selected.canonicalize(rows, stride, selected.canonicalize == canonicalizeScalar ? count : stride);
+}
+
+const char* CubeBatch::kernelName() {
+    return kernel().name;
+}
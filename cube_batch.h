@@ -0,0 +1,44 @@
+#ifndef CUBE_BATCH_H
+#define CUBE_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cube_state.h"
+
+// Many 3x3 cube states stored structure-of-arrays: row f holds facelet f of
+// every state, so applying one move to the whole batch permutes rows.
+//
+// Each move is precomputed as the cycles of its facelet permutation; only the
+// 12 to 20 facelets a move touches are rewritten, 32 (AVX2) or 16 (SSE2)
+// states per instruction, with a portable 8-states-per-word fallback. The
+// kernel is picked at runtime from what the CPU supports.
+class CubeBatch {
+public:
+    explicit CubeBatch(size_t count);
+
+    size_t size() const { return count; }
+
+    // Apply the same move(s) to every state in the batch
+    void applyMove(int move);
+    void applyMoves(const uint8_t* moves, size_t moveCount);
+
+    // Replace every state by its symmetry class representative
+    // (CubeSymmetry::canonical), 32 states per step with AVX2
+    void canonicalize();
+
+    void setState(size_t index, const CubeState& state);
+    CubeState getState(size_t index) const;
+    uint8_t facelet(size_t index, int facelet) const { return rows[facelet * stride + index]; }
+
+    // Name of the kernel in use ("avx2", "sse2" or "scalar")
+    static const char* kernelName();
+
+private:
+    size_t count;
+    size_t stride;              // row length, padded to whole 32-byte vectors
+    uint8_t* rows;              // 54 rows, 32-byte aligned inside storage
+    std::vector<uint8_t> storage;
+};
+
+#endif
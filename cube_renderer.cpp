@@ -0,0 +1,468 @@
+#define GL_GLEXT_PROTOTYPES
+#include "cube_renderer.h"
+#include "frame_stats.h"
+#include "shader_pipeline.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+// Color RGB values for each face (see CubeColor)
+const uint8_t stickerColors[6][3] = {
+    {255, 255, 255},  // WHITE
+    {255, 255,   0},  // YELLOW
+    {255,   0,   0},  // RED
+    {255, 128,   0},  // ORANGE
+    {  0,   0, 255},  // BLUE
+    {  0, 255,   0}   // GREEN
+};
+
+// Colour for inside faces, only visible in the gap while a layer turns
+const uint8_t insideColor[3] = {13, 13, 13};
+
+// Unit cubie corners and normals, faces in CubeFace order
+// (front, back, left, right, top, bottom)
+const float faceCorners[6][4][3] = {
+    {{-0.5f, -0.5f,  0.5f}, { 0.5f, -0.5f,  0.5f}, { 0.5f,  0.5f,  0.5f}, {-0.5f,  0.5f,  0.5f}},
+    {{-0.5f, -0.5f, -0.5f}, {-0.5f,  0.5f, -0.5f}, { 0.5f,  0.5f, -0.5f}, { 0.5f, -0.5f, -0.5f}},
+    {{-0.5f, -0.5f, -0.5f}, {-0.5f,  0.5f, -0.5f}, {-0.5f,  0.5f,  0.5f}, {-0.5f, -0.5f,  0.5f}},
+    {{ 0.5f, -0.5f, -0.5f}, { 0.5f, -0.5f,  0.5f}, { 0.5f,  0.5f,  0.5f}, { 0.5f,  0.5f, -0.5f}},
+    {{-0.5f,  0.5f, -0.5f}, {-0.5f,  0.5f,  0.5f}, { 0.5f,  0.5f,  0.5f}, { 0.5f,  0.5f, -0.5f}},
+    {{-0.5f, -0.5f, -0.5f}, { 0.5f, -0.5f, -0.5f}, { 0.5f, -0.5f,  0.5f}, {-0.5f, -0.5f,  0.5f}}
+};
+const float faceNormals[6][3] = {
+    { 0.0f,  0.0f,  1.0f},
+    { 0.0f,  0.0f, -1.0f},
+    {-1.0f,  0.0f,  0.0f},
+    { 1.0f,  0.0f,  0.0f},
+    { 0.0f,  1.0f,  0.0f},
+    { 0.0f, -1.0f,  0.0f}
+};
+
+// The 12 cubie edges as corner pairs (bottom square, top square, verticals)
+const float edgeLines[24][3] = {
+    {-0.5f, -0.5f, -0.5f}, { 0.5f, -0.5f, -0.5f},
+    { 0.5f, -0.5f, -0.5f}, { 0.5f, -0.5f,  0.5f},
+    { 0.5f, -0.5f,  0.5f}, {-0.5f, -0.5f,  0.5f},
+    {-0.5f, -0.5f,  0.5f}, {-0.5f, -0.5f, -0.5f},
+    {-0.5f,  0.5f, -0.5f}, { 0.5f,  0.5f, -0.5f},
+    { 0.5f,  0.5f, -0.5f}, { 0.5f,  0.5f,  0.5f},
+    { 0.5f,  0.5f,  0.5f}, {-0.5f,  0.5f,  0.5f},
+    {-0.5f,  0.5f,  0.5f}, {-0.5f,  0.5f, -0.5f},
+    {-0.5f, -0.5f, -0.5f}, {-0.5f,  0.5f, -0.5f},
+    { 0.5f, -0.5f, -0.5f}, { 0.5f,  0.5f, -0.5f},
+    { 0.5f, -0.5f,  0.5f}, { 0.5f,  0.5f,  0.5f},
+    {-0.5f, -0.5f,  0.5f}, {-0.5f,  0.5f,  0.5f}
+};
+
+struct FaceVertex {
+    float position[3];
+    float normal[3];
+};
+
+} // namespace
+
+const int CubeRenderer::FACE_VERTICES;
+const int CubeRenderer::LINE_VERTICES;
+const int CubeRenderer::FACE_INDICES;
+
+CubeRenderer::CubeRenderer()
+    : size(0), spacing(1.1f), faceBuffer(0), colorBuffer(0), lineBuffer(0), indexBuffer(0),
+      batchAxis(-1), batchLayer(-1) {
+}
+
+CubeRenderer::~CubeRenderer() {
+    if (faceBuffer) {
+        GLuint buffers[3] = {faceBuffer, colorBuffer, lineBuffer};
+        glDeleteBuffers(3, buffers);
+    }
+    if (indexBuffer) glDeleteBuffers(1, &indexBuffer);
+}
+
+const uint8_t* CubeRenderer::stickerColor(int color) {
+    return stickerColors[color];
+}
+
+void CubeRenderer::build(int cubeSize, float cubieSpacing) {
+    size = cubeSize;
+    spacing = cubieSpacing;
+
+    // Surface cubies only: inner rows keep just their two end slots
+    slots.clear();
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++) {
+            bool outer = x == 0 || x == size - 1 || y == 0 || y == size - 1;
+            int step = outer ? 1 : size - 1;
+            for (int z = 0; z < size; z += step) {
+                Slot slot = {(uint16_t)x, (uint16_t)y, (uint16_t)z};
+                slots.push_back(slot);
+            }
+        }
+    }
+
+    // Cubies of every layer, for batches and per-layer colour updates
+    layerCubies.assign(3 * size, std::vector<uint32_t>());
+    for (size_t c = 0; c < slots.size(); c++) {
+        layerCubies[0 * size + slots[c].x].push_back((uint32_t)c);
+        layerCubies[1 * size + slots[c].y].push_back((uint32_t)c);
+        layerCubies[2 * size + slots[c].z].push_back((uint32_t)c);
+    }
+
+    colorData.assign(slots.size() * FACE_VERTICES * 4, 255);
+    cubieDirty.assign(slots.size(), 0);
+    dirtyCubies.clear();
+    markAllDirty();
+    batchAxis = batchLayer = -1;
+
+    // Old buffers have the wrong size; recreate them on the next draw
+    if (faceBuffer) {
+        GLuint buffers[3] = {faceBuffer, colorBuffer, lineBuffer};
+        glDeleteBuffers(3, buffers);
+        faceBuffer = colorBuffer = lineBuffer = 0;
+    }
+    if (indexBuffer) {
+        glDeleteBuffers(1, &indexBuffer);
+        indexBuffer = 0;
+    }
+}
+
+void CubeRenderer::createBuffers() {
+    float half = (size - 1) * 0.5f;
+    std::vector<FaceVertex> faces(slots.size() * FACE_VERTICES);
+    std::vector<float> lines(slots.size() * LINE_VERTICES * 3);
+
+    for (size_t c = 0; c < slots.size(); c++) {
+        float center[3] = {(slots[c].x - half) * spacing, (slots[c].y - half) * spacing, (slots[c].z - half) * spacing};
+        FaceVertex* vertex = &faces[c * FACE_VERTICES];
+        for (int face = 0; face < 6; face++) {
+            for (int corner = 0; corner < 4; corner++, vertex++) {
+                for (int a = 0; a < 3; a++) {
+                    vertex->position[a] = center[a] + faceCorners[face][corner][a];
+                    vertex->normal[a] = faceNormals[face][a];
+                }
+            }
+        }
+        float* line = &lines[c * LINE_VERTICES * 3];
+        for (int v = 0; v < LINE_VERTICES; v++) {
+            for (int a = 0; a < 3; a++) {
+                *line++ = center[a] + edgeLines[v][a];
+            }
+        }
+    }
+
+    GLuint buffers[3];
+    glGenBuffers(3, buffers);
+    faceBuffer = buffers[0];
+    colorBuffer = buffers[1];
+    lineBuffer = buffers[2];
+
+    glBindBuffer(GL_ARRAY_BUFFER, faceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, faces.size() * sizeof(FaceVertex), faces.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, lineBuffer);
+    glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(float), lines.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+    glBufferData(GL_ARRAY_BUFFER, colorData.size(), colorData.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    std::fill(cubieDirty.begin(), cubieDirty.end(), 0);
+    dirtyCubies.clear();
+
+    if (shaderPipeline) {
+        // Quad corners 0 1 2 3 become triangles 0 1 2 and 0 2 3
+        std::vector<uint32_t> indices(slots.size() * FACE_INDICES);
+        uint32_t* index = indices.data();
+        for (uint32_t quad = 0; quad < slots.size() * 6; quad++, index += 6) {
+            uint32_t first = quad * 4;
+            index[0] = first;
+            index[1] = first + 1;
+            index[2] = first + 2;
+            index[3] = first;
+            index[4] = first + 2;
+            index[5] = first + 3;
+        }
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+void CubeRenderer::fillColors(const NxNCubeState& state, size_t cubie) {
+    uint8_t* color = &colorData[cubie * FACE_VERTICES * 4];
+    for (int face = 0; face < 6; face++) {
+        int facelet = state.faceletAt(slots[cubie].x, slots[cubie].y, slots[cubie].z, face);
+        const uint8_t* rgb = facelet >= 0 ? stickerColors[state.facelet(facelet)] : insideColor;
+        for (int corner = 0; corner < 4; corner++, color += 4) {
+            color[0] = rgb[0];
+            color[1] = rgb[1];
+            color[2] = rgb[2];
+        }
+    }
+}
+
+void CubeRenderer::markDirty(size_t cubie) {
+    if (!cubieDirty[cubie]) {
+        cubieDirty[cubie] = 1;
+        dirtyCubies.push_back((uint32_t)cubie);
+    }
+}
+
+void CubeRenderer::markAllDirty() {
+    for (size_t c = 0; c < slots.size(); c++) {
+        markDirty(c);
+    }
+}
+
+void CubeRenderer::updateColors(const NxNCubeState& state) {
+    for (size_t c = 0; c < slots.size(); c++) {
+        fillColors(state, c);
+    }
+    markAllDirty();
+}
+
+void CubeRenderer::updateLayerColors(const NxNCubeState& state, int axis, int layer) {
+    const std::vector<uint32_t>& cubies = layerCubies[axis * size + layer];
+    for (size_t i = 0; i < cubies.size(); i++) {
+        fillColors(state, cubies[i]);
+        markDirty(cubies[i]);
+    }
+}
+
+// Upload the colours changed since the last draw, one call per run of
+// neighbouring cubies. A y or z layer is spread over the whole x-major
+// buffer, so covering it with a single span would upload most of the cube.
+void CubeRenderer::uploadColors() {
+    if (!faceBuffer) {
+        createBuffers();
+        return;
+    }
+    if (dirtyCubies.empty()) return;
+
+    std::sort(dirtyCubies.begin(), dirtyCubies.end());
+    size_t cubieBytes = FACE_VERTICES * 4;
+    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+    for (size_t i = 0; i < dirtyCubies.size();) {
+        size_t first = dirtyCubies[i];
+        size_t end = first;
+        while (i < dirtyCubies.size() && dirtyCubies[i] == end) {
+            cubieDirty[end++] = 0;
+            i++;
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, first * cubieBytes, (end - first) * cubieBytes, &colorData[first * cubieBytes]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirtyCubies.clear();
+}
+
+// Build the batches for a turning layer once; later frames of the same turn
+// reuse them. Face and line buffers hold the same number of vertices per
+// cubie, so the ranges serve both.
+void CubeRenderer::prepareBatches(int axis, int layer) {
+    static_assert(FACE_VERTICES == LINE_VERTICES, "face and line ranges must match");
+    if (axis == batchAxis && layer == batchLayer) return;
+
+    layerBatch.firsts.clear();
+    layerBatch.counts.clear();
+    restBatch.firsts.clear();
+    restBatch.counts.clear();
+    layerBatch.vertices = (long)layerCubies[axis * size + layer].size() * FACE_VERTICES;
+    restBatch.vertices = (long)slots.size() * FACE_VERTICES - layerBatch.vertices;
+
+    // Walk the layer's cubies in buffer order; the gaps between them are the rest
+    const std::vector<uint32_t>& cubies = layerCubies[axis * size + layer];
+    size_t next = 0;
+    for (size_t i = 0; i <= cubies.size(); i++) {
+        size_t cubie = i < cubies.size() ? cubies[i] : slots.size();
+        if (cubie > next) {
+            restBatch.firsts.push_back((GLint)(next * FACE_VERTICES));
+            restBatch.counts.push_back((GLsizei)((cubie - next) * FACE_VERTICES));
+        }
+        if (i < cubies.size()) {
+            GLint first = (GLint)(cubie * FACE_VERTICES);
+            if (!layerBatch.counts.empty() && layerBatch.firsts.back() + layerBatch.counts.back() == first) {
+                layerBatch.counts.back() += FACE_VERTICES;
+            } else {
+                layerBatch.firsts.push_back(first);
+                layerBatch.counts.push_back(FACE_VERTICES);
+            }
+        }
+        next = cubie + 1;
+    }
+
+    if (shaderPipeline) {
+        fillIndexRanges(layerBatch);
+        fillIndexRanges(restBatch);
+    }
+    batchAxis = axis;
+    batchLayer = layer;
+}
+
+// Vertex ranges cover whole cubies, so they map to index ranges exactly
+void CubeRenderer::fillIndexRanges(Batch& batch) const {
+    batch.indexOffsets.clear();
+    batch.indexCounts.clear();
+    for (size_t i = 0; i < batch.firsts.size(); i++) {
+        size_t first = (size_t)batch.firsts[i] / FACE_VERTICES * FACE_INDICES;
+        batch.indexOffsets.push_back((const void*)(first * sizeof(uint32_t)));
+        batch.indexCounts.push_back(batch.counts[i] / FACE_VERTICES * FACE_INDICES);
+    }
+}
+
+void CubeRenderer::drawFaces(const Batch* batch) {
+    if (shaderPipeline) {
+        drawFacesCore(batch);
+        return;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    glBindBuffer(GL_ARRAY_BUFFER, faceBuffer);
+    glVertexPointer(3, GL_FLOAT, sizeof(FaceVertex), (const void*)offsetof(FaceVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(FaceVertex), (const void*)offsetof(FaceVertex, normal));
+    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+    glColorPointer(3, GL_UNSIGNED_BYTE, 4, (const void*)0);
+
+    if (batch) {
+        if (!batch->firsts.empty()) {
+            glMultiDrawArrays(GL_QUADS, batch->firsts.data(), batch->counts.data(), (GLsizei)batch->firsts.size());
+            countDrawCall(batch->vertices);
+        }
+    } else {
+        glDrawArrays(GL_QUADS, 0, (GLsizei)(slots.size() * FACE_VERTICES));
+        countDrawCall((long)slots.size() * FACE_VERTICES);
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void CubeRenderer::drawLines(const Batch* batch) {
+    if (shaderPipeline) {
+        drawLinesCore(batch);
+        return;
+    }
+    // Draw black edges
+    glColor3f(0.0f, 0.0f, 0.0f);
+    glLineWidth(5.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, lineBuffer);
+    glVertexPointer(3, GL_FLOAT, 0, (const void*)0);
+
+    if (batch) {
+        if (!batch->firsts.empty()) {
+            glMultiDrawArrays(GL_LINES, batch->firsts.data(), batch->counts.data(), (GLsizei)batch->firsts.size());
+            countDrawCall(batch->vertices);
+        }
+    } else {
+        glDrawArrays(GL_LINES, 0, (GLsizei)(slots.size() * LINE_VERTICES));
+        countDrawCall((long)slots.size() * LINE_VERTICES);
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Core profile: the same buffers as generic attributes, quads as indexed triangles
+void CubeRenderer::drawFacesCore(const Batch* batch) {
+    glEnableVertexAttribArray(ShaderPipeline::POSITION);
+    glEnableVertexAttribArray(ShaderPipeline::NORMAL);
+    glEnableVertexAttribArray(ShaderPipeline::COLOR);
+
+    glBindBuffer(GL_ARRAY_BUFFER, faceBuffer);
+    glVertexAttribPointer(ShaderPipeline::POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(FaceVertex),
+                          (const void*)offsetof(FaceVertex, position));
+    glVertexAttribPointer(ShaderPipeline::NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(FaceVertex),
+                          (const void*)offsetof(FaceVertex, normal));
+    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+    glVertexAttribPointer(ShaderPipeline::COLOR, 3, GL_UNSIGNED_BYTE, GL_TRUE, 4, (const void*)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    if (batch) {
+        if (!batch->indexCounts.empty()) {
+            glMultiDrawElements(GL_TRIANGLES, batch->indexCounts.data(), GL_UNSIGNED_INT,
+                                batch->indexOffsets.data(), (GLsizei)batch->indexCounts.size());
+            countDrawCall(batch->vertices);
+        }
+    } else {
+        glDrawElements(GL_TRIANGLES, (GLsizei)(slots.size() * FACE_INDICES), GL_UNSIGNED_INT, (const void*)0);
+        countDrawCall((long)slots.size() * FACE_VERTICES);
+    }
+
+    glDisableVertexAttribArray(ShaderPipeline::COLOR);
+    glDisableVertexAttribArray(ShaderPipeline::NORMAL);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void CubeRenderer::drawLinesCore(const Batch* batch) {
+    // Black edges; the normal is irrelevant as black stays black when lit
+    glVertexAttrib3f(ShaderPipeline::NORMAL, 0.0f, 0.0f, 1.0f);
+    glVertexAttrib4f(ShaderPipeline::COLOR, 0.0f, 0.0f, 0.0f, 1.0f);
+    glLineWidth(5.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, lineBuffer);
+    glEnableVertexAttribArray(ShaderPipeline::POSITION);
+    glVertexAttribPointer(ShaderPipeline::POSITION, 3, GL_FLOAT, GL_FALSE, 0, (const void*)0);
+
+    if (batch) {
+        if (!batch->firsts.empty()) {
+            glMultiDrawArrays(GL_LINES, batch->firsts.data(), batch->counts.data(), (GLsizei)batch->firsts.size());
+            countDrawCall(batch->vertices);
+        }
+    } else {
+        glDrawArrays(GL_LINES, 0, (GLsizei)(slots.size() * LINE_VERTICES));
+        countDrawCall((long)slots.size() * LINE_VERTICES);
+    }
+
+    glDisableVertexAttribArray(ShaderPipeline::POSITION);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void CubeRenderer::drawAll() {
+    uploadColors();
+    drawFaces(nullptr);
+    drawLines(nullptr);
+}
+
+void CubeRenderer::drawLayer(int axis, int layer) {
+    uploadColors();
+    prepareBatches(axis, layer);
+    drawFaces(&layerBatch);
+    drawLines(&layerBatch);
+}
+
+void CubeRenderer::drawExceptLayer(int axis, int layer) {
+    uploadColors();
+    prepareBatches(axis, layer);
+    drawFaces(&restBatch);
+    drawLines(&restBatch);
+}
+
+void CubeRenderer::drawInteriorCap(int axis, int layer, int side) const {
+    // No cap outside the cube: an outer layer's turn has only one inner side
+    if (size < 3 || layer < 0 || layer > size - 1 || layer + side < 0 || layer + side > size - 1) return;
+
+    float half = (size - 1) * 0.5f;
+    float plane = (layer - half) * spacing + side * 0.5f;
+    float extent = (size - 2 - half) * spacing + 0.5f;
+    float corners[4][2] = {{-extent, -extent}, {extent, -extent}, {extent, extent}, {-extent, extent}};
+
+    float normal[3] = {axis == 0 ? (float)side : 0.0f, axis == 1 ? (float)side : 0.0f, axis == 2 ? (float)side : 0.0f};
+    float points[4][3];
+    for (int i = 0; i < 4; i++) {
+        points[i][axis] = plane;
+        points[i][(axis + 1) % 3] = corners[i][0];
+        points[i][(axis + 2) % 3] = corners[i][1];
+    }
+
+    if (shaderPipeline) {
+        shaderPipeline->drawQuad(&points[0][0], normal, insideColor);
+    } else {
+        glColor3ubv(insideColor);
+        glBegin(GL_QUADS);
+        glNormal3fv(normal);
+        for (int i = 0; i < 4; i++) {
+            glVertex3fv(points[i]);
+        }
+        glEnd();
+    }
+    countDrawCall(4);
+}
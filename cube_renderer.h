@@ -0,0 +1,99 @@
+#ifndef CUBE_RENDERER_H
+#define CUBE_RENDERER_H
+
+#include <GL/glut.h>
+#include <cstdint>
+#include <vector>
+#include "nxn_cube_state.h"
+
+// Retained-mode renderer for the surface cubies of an NxN cube.
+//
+// The geometry of every surface cubie (6 faces and the black edge lines) is
+// uploaded once into static vertex buffers. Sticker colours live in their own
+// buffer, which is only rewritten when the cube state changes, so a still
+// frame is two draw calls. While a layer turns, the layer and the rest of the
+// cube are drawn as two glMultiDrawArrays batches each; the batches are built
+// when the layer starts turning and reused for every frame of the turn.
+// After a turn only the colours of that layer's cubies are refreshed and
+// uploaded, one glBufferSubData per run of neighbouring cubies.
+// With a ShaderPipeline (core profile) the same buffers feed the shaders and
+// the quads, which core profiles cannot draw, go through an index buffer of
+// triangles.
+//
+// Needs a current GL context; buffers are created on the first draw.
+class CubeRenderer {
+private:
+    struct Slot {
+        uint16_t x, y, z;
+    };
+
+    int size;
+    float spacing;
+    // Vertex ranges for glMultiDrawArrays, neighbouring cubies merged, and
+    // the same ranges of the triangle index buffer for the core profile
+    struct Batch {
+        std::vector<GLint> firsts;
+        std::vector<GLsizei> counts;
+        std::vector<const void*> indexOffsets;
+        std::vector<GLsizei> indexCounts;
+        long vertices;
+    };
+
+    std::vector<Slot> slots;           // surface cubies in buffer order (x, then y, then z)
+    std::vector<std::vector<uint32_t> > layerCubies; // [axis * size + layer], cubie indices
+    std::vector<uint8_t> colorData;    // RGBA per face vertex
+    GLuint faceBuffer;                 // position + normal per face vertex
+    GLuint colorBuffer;
+    GLuint lineBuffer;                 // position per edge vertex
+    GLuint indexBuffer;                // two triangles per face quad (core profile only)
+    std::vector<uint8_t> cubieDirty;   // per cubie: colours changed since the last upload
+    std::vector<uint32_t> dirtyCubies; // the same cubies, in the order they were marked
+
+    // Batches of the turning layer and of the rest of the cube
+    int batchAxis, batchLayer;
+    Batch layerBatch;
+    Batch restBatch;
+
+    void createBuffers();
+    void uploadColors();
+    void fillColors(const NxNCubeState& state, size_t cubie);
+    void markDirty(size_t cubie);
+    void markAllDirty();
+    void prepareBatches(int axis, int layer);
+    void drawFaces(const Batch* batch);
+    void drawLines(const Batch* batch);
+    void fillIndexRanges(Batch& batch) const;
+    void drawFacesCore(const Batch* batch);
+    void drawLinesCore(const Batch* batch);
+
+public:
+    static const int FACE_VERTICES = 24;   // per cubie
+    static const int LINE_VERTICES = 24;
+    static const int FACE_INDICES = 36;
+
+    CubeRenderer();
+    ~CubeRenderer();
+
+    // RGB of a sticker colour (CubeColor), shared with the cube wall
+    static const uint8_t* stickerColor(int color);
+
+    // Lay out the surface cubies of a cube of this size; buffers follow on the next draw
+    void build(int cubeSize, float cubieSpacing);
+    int getSize() const { return size; }
+
+    // Refresh the sticker colours from the state, of every cubie or only of
+    // the cubies in one layer (uploaded on the next draw)
+    void updateColors(const NxNCubeState& state);
+    void updateLayerColors(const NxNCubeState& state, int axis, int layer);
+
+    // Draw every cubie, only the cubies of one layer, or every cubie but that layer
+    void drawAll();
+    void drawLayer(int axis, int layer);
+    void drawExceptLayer(int axis, int layer);
+
+    // Cover the hollow interior of a layer on one side (-1 or +1) along axis,
+    // seen through the gap while a neighbouring layer turns
+    void drawInteriorCap(int axis, int layer, int side) const;
+};
+
+#endif
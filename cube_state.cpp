@@ -0,0 +1,273 @@
+#include "cube_state.h"
+
+namespace {
+
+// Outward normal, column axis and row axis of each face (see cube_state.h)
+const int faceNormals[6][3] = {
+    { 0,  0,  1},  // Front
+    { 0,  0, -1},  // Back
+    {-1,  0,  0},  // Left
+    { 1,  0,  0},  // Right
+    { 0,  1,  0},  // Top
+    { 0, -1,  0}   // Bottom
+};
+const int faceColumns[6][3] = {
+    { 1,  0,  0},
+    {-1,  0,  0},
+    { 0,  0,  1},
+    { 0,  0, -1},
+    { 1,  0,  0},
+    { 1,  0,  0}
+};
+const int faceRows[6][3] = {
+    { 0, -1,  0},
+    { 0, -1,  0},
+    { 0, -1,  0},
+    { 0, -1,  0},
+    { 0,  0,  1},
+    { 0,  0, -1}
+};
+
+// Direction of a clockwise turn as a right-handed quarter turn about each axis.
+// Matches the angle signs used when animating layers.
+const int clockwiseSigns[3] = {-1, 1, -1};
+
+int dot(const int* a, const int* b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+int faceletFromGeometry(const int* p, int face) {
+    if (dot(p, faceNormals[face]) != 1) return -1;
+    return face * 9 + (dot(p, faceRows[face]) + 1) * 3 + (dot(p, faceColumns[face]) + 1);
+}
+
+// Right-handed quarter turn about axis, sign = +1 or -1
+void quarterTurn(int* v, int axis, int sign) {
+    int u = (axis + 1) % 3;
+    int w = (axis + 2) % 3;
+    int vu = v[u];
+    int vw = v[w];
+    v[u] = -sign * vw;
+    v[w] = sign * vu;
+}
+
+struct MoveTables {
+    uint8_t gather[CubeState::MOVE_COUNT][54];
+    uint8_t moved[CubeState::MOVE_COUNT][20];  // at most 12 strip + 8 face facelets change
+    int movedCount[CubeState::MOVE_COUNT];
+    uint64_t zobrist[54][6];
+    uint64_t solvedKey;
+
+    MoveTables() {
+        // Position and normal of every facelet
+        int position[54][3];
+        int normal[54][3];
+        for (int x = -1; x <= 1; x++) {
+            for (int y = -1; y <= 1; y++) {
+                for (int z = -1; z <= 1; z++) {
+                    int p[3] = {x, y, z};
+                    for (int f = 0; f < 6; f++) {
+                        int index = faceletFromGeometry(p, f);
+                        if (index < 0) continue;
+                        for (int a = 0; a < 3; a++) {
+                            position[index][a] = p[a];
+                            normal[index][a] = faceNormals[f][a];
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int move = 0; move < CubeState::MOVE_COUNT; move++) {
+            int axis = CubeState::moveAxis(move);
+            int offset = CubeState::moveOffset(move);
+            int quarters = CubeState::moveTurn(move) + 1; // cw, half, ccw = 1, 2, 3 clockwise quarters
+
+            for (int i = 0; i < 54; i++) {
+                int p[3] = {position[i][0], position[i][1], position[i][2]};
+                int n[3] = {normal[i][0], normal[i][1], normal[i][2]};
+                if (p[axis] == offset) {
+                    for (int q = 0; q < quarters; q++) {
+                        quarterTurn(p, axis, clockwiseSigns[axis]);
+                        quarterTurn(n, axis, clockwiseSigns[axis]);
+                    }
+                }
+                gather[move][faceletFromGeometry(p, CubeState::faceFromNormal(n))] = (uint8_t)i;
+            }
+
+            movedCount[move] = 0;
+            for (int i = 0; i < 54; i++) {
+                if (gather[move][i] != i) moved[move][movedCount[move]++] = (uint8_t)i;
+            }
+        }
+
+        solvedKey = 0;
+        for (int i = 0; i < 54; i++) {
+            for (int c = 0; c < 6; c++) {
+                zobrist[i][c] = CubeState::zobristKey(i, c);
+            }
+            solvedKey ^= zobrist[i][i / 9];
+        }
+    }
+};
+
+const MoveTables& moveTables() {
+    static const MoveTables tables;
+    return tables;
+}
+
+} // namespace
+
+void CubeState::reset() {
+    for (int i = 0; i < 54; i++) {
+        facelets[i] = (uint8_t)(i / 9);
+    }
+    key = moveTables().solvedKey;
+}
+
+void CubeState::setFacelets(const uint8_t* colors) {
+    const MoveTables& tables = moveTables();
+    memcpy(facelets, colors, 54);
+    key = 0;
+    for (int i = 0; i < 54; i++) {
+        key ^= tables.zobrist[i][facelets[i]];
+    }
+}
+
+void CubeState::setFacelet(int index, uint8_t color) {
+    const MoveTables& tables = moveTables();
+    key ^= tables.zobrist[index][facelets[index]] ^ tables.zobrist[index][color];
+    facelets[index] = color;
+}
+
+bool CubeState::isSolved() const {
+    // Solved means every face is a single colour (slice moves may have turned the whole cube)
+    for (int f = 0; f < 6; f++) {
+        const uint8_t* face = facelets + f * 9;
+        for (int i = 0; i < 9; i++) {
+            if (face[i] != face[4]) return false;
+        }
+    }
+    return true;
+}
+
+void CubeState::applyMove(int move) {
+    const MoveTables& tables = moveTables();
+    permute(tables.gather[move], tables.moved[move], tables.movedCount[move]);
+}
+
+void CubeState::permute(const uint8_t* table, const uint8_t* moved, int movedCount) {
+    permuteFacelets(facelets, key, table, moved, movedCount);
+}
+
+void CubeState::permuteFacelets(uint8_t* facelets, uint64_t& key, const uint8_t* table, const uint8_t* moved,
+                                int movedCount) {
+    const MoveTables& tables = moveTables();
+    uint8_t old[54];
+    memcpy(old, facelets, 54);
+
+    // Most facelets move: hashing the result is cheaper than two keys per change
+    if (movedCount > FACELET_COUNT / 2) {
+        uint64_t hash = 0;
+        for (int i = 0; i < FACELET_COUNT; i++) {
+            facelets[i] = old[table[i]];
+            hash ^= tables.zobrist[i][facelets[i]];
+        }
+        key = hash;
+        return;
+    }
+
+    // Only the moved facelets change, and only they change the hash
+    uint64_t delta = 0;
+    for (int k = 0; k < movedCount; k++) {
+        int i = moved[k];
+        uint8_t color = old[table[i]];
+        facelets[i] = color;
+        delta ^= tables.zobrist[i][old[i]] ^ tables.zobrist[i][color];
+    }
+    key ^= delta;
+}
+
+void CubeState::applyMoves(const uint8_t* moves, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        applyMove(moves[i]);
+    }
+}
+
+const char* CubeState::moveName(int move) {
+    static const char* names[MOVE_COUNT] = {
+        "L", "L2", "L'", "C", "C2", "C'", "X", "X2", "X'",
+        "D", "D2", "D'", "M", "M2", "M'", "U", "U2", "U'",
+        "B", "B2", "B'", "S", "S2", "S'", "F", "F2", "F'"
+    };
+    return move >= 0 && move < MOVE_COUNT ? names[move] : "?";
+}
+
+int CubeState::parseMove(const char*& text, const char* end) {
+    while (text < end && (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n')) text++;
+    if (text >= end) return -1;
+
+    int layer;
+    switch (*text) {
+        case 'L': case 'l': layer = 0; break;
+        case 'C': case 'c': layer = 1; break;
+        case 'X': case 'x': layer = 2; break;
+        case 'D': case 'd': layer = 3; break;
+        case 'M': case 'm': layer = 4; break;
+        case 'U': case 'u': layer = 5; break;
+        case 'B': case 'b': layer = 6; break;
+        case 'S': case 's': layer = 7; break;
+        case 'F': case 'f': layer = 8; break;
+        default: return -1;
+    }
+    text++;
+
+    int turn = 0;
+    if (text < end && *text == '2') {
+        turn = 1;
+        text++;
+    } else if (text < end && *text == '\'') {
+        turn = 2;
+        text++;
+    }
+    return layer * 3 + turn;
+}
+
+int CubeState::faceletAt(int x, int y, int z, int face) {
+    int p[3] = {x, y, z};
+    return faceletFromGeometry(p, face);
+}
+
+const int* CubeState::faceNormal(int face) {
+    return faceNormals[face];
+}
+
+const int* CubeState::faceColumnAxis(int face) {
+    return faceColumns[face];
+}
+
+const int* CubeState::faceRowAxis(int face) {
+    return faceRows[face];
+}
+
+int CubeState::clockwiseSign(int axis) {
+    return clockwiseSigns[axis];
+}
+
+int CubeState::faceFromNormal(const int* normal) {
+    for (int f = 0; f < 6; f++) {
+        if (faceNormals[f][0] == normal[0] && faceNormals[f][1] == normal[1] && faceNormals[f][2] == normal[2]) {
+            return f;
+        }
+    }
+    return -1;
+}
+
+const uint8_t* CubeState::moveTable(int move) {
+    return moveTables().gather[move];
+}
+
+const uint8_t* CubeState::movedFacelets(int move, int& count) {
+    count = moveTables().movedCount[move];
+    return moveTables().moved[move];
+}
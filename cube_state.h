@@ -0,0 +1,125 @@
+#ifndef CUBE_STATE_H
+#define CUBE_STATE_H
+
+#include <cstdint>
+#include <cstring>
+
+// Faces in drawing order (front, back, left, right, top, bottom).
+// In the solved state every sticker on face f has colour f (see CubeColor).
+enum CubeFace
+{
+    FACE_FRONT = 0,
+    FACE_BACK,
+    FACE_LEFT,
+    FACE_RIGHT,
+    FACE_TOP,
+    FACE_BOTTOM
+};
+
+// Render-independent 3x3 cube state stored as 54 facelets.
+//
+// Facelet index = face * 9 + row * 3 + col, with each face laid out as seen
+// from outside the cube:
+//   front: col +x, row -y      back:   col -x, row -y
+//   left:  col +z, row -y      right:  col -z, row -y
+//   top:   col +x, row +z      bottom: col +x, row -z
+//
+// A move is a layer turn: move = layer * 3 + turn, where layer = axis * 3 + (offset + 1)
+// (offset -1..1 along the axis, like the RubiksCube origins) and turn is
+// 0 = clockwise, 1 = half turn, 2 = counter-clockwise. "Clockwise" follows the
+// existing keyboard/animation convention of the renderer. Every move is a
+// single precomputed 54-byte gather.
+//
+// Each state carries a 64-bit Zobrist hash (XOR of zobristKey(i, colour) over
+// all facelets). Moves update it from only the facelets they change, so
+// hash() and the early-out in operator== are O(1).
+class CubeState {
+private:
+    uint8_t facelets[54];
+    uint64_t key;
+
+public:
+    static const int FACELET_COUNT = 54;
+    static const int LAYER_COUNT = 9;
+    static const int MOVE_COUNT = 27;
+
+    CubeState() { reset(); }
+
+    void reset();
+    bool isSolved() const;
+    uint64_t hash() const { return key; }
+
+    void applyMove(int move);
+    void applyMoves(const uint8_t* moves, size_t count);
+
+    // Apply any facelet gather (facelet i takes old facelet table[i]) given
+    // the facelets it changes; a move is one, so is a whole compiled algorithm
+    void permute(const uint8_t* table, const uint8_t* moved, int movedCount);
+
+    // The same on 54 facelets and their hash held elsewhere; a 3x3
+    // NxNCubeState turns through it so both hash the same way
+    static void permuteFacelets(uint8_t* facelets, uint64_t& key, const uint8_t* table, const uint8_t* moved,
+                                int movedCount);
+
+    uint8_t facelet(int index) const { return facelets[index]; }
+    uint8_t facelet(int face, int row, int col) const { return facelets[face * 9 + row * 3 + col]; }
+    const uint8_t* data() const { return facelets; }
+
+    // Replace the facelets (hash recomputed) or a single facelet (hash updated)
+    void setFacelets(const uint8_t* colors);
+    void setFacelet(int index, uint8_t color);
+
+    bool operator==(const CubeState& other) const {
+        return key == other.key && memcmp(facelets, other.facelets, 54) == 0;
+    }
+    bool operator!=(const CubeState& other) const { return !(*this == other); }
+
+    // Move helpers
+    static int layerIndex(int axis, int offset) { return axis * 3 + offset + 1; }
+    static int moveFor(int axis, int offset, bool clockwise) { return layerIndex(axis, offset) * 3 + (clockwise ? 0 : 2); }
+    static int moveLayer(int move) { return move / 3; }
+    static int moveAxis(int move) { return move / 9; }
+    static int moveOffset(int move) { return (move / 3) % 3 - 1; }
+    static int moveTurn(int move) { return move % 3; }
+    static int inverseMove(int move) { return move - move % 3 + (2 - move % 3); }
+
+    // Name of a move using the keyboard letters (U M D, L C X, F B plus S for
+    // the front/back slice), "'" for counter-clockwise and "2" for a half turn
+    static const char* moveName(int move);
+
+    // Parse one move written as moveName() does (letters in either case),
+    // skipping leading whitespace. Advances text; returns -1 on a bad move or
+    // at the end of the input.
+    static int parseMove(const char*& text, const char* end);
+
+    // Facelet index of the sticker on the given face of the cubie at (x, y, z),
+    // coordinates in -1..1, or -1 if that face is inside the cube.
+    static int faceletAt(int x, int y, int z, int face);
+
+    // Face geometry shared with the NxN engine: outward normal, column and row
+    // direction of each face, and the rotation sign of a clockwise turn per axis
+    static const int* faceNormal(int face);
+    static const int* faceColumnAxis(int face);
+    static const int* faceRowAxis(int face);
+    static int clockwiseSign(int axis);
+    static int faceFromNormal(const int* normal);
+
+    // Raw gather table for a move: after the move, facelet i holds old facelet table[i].
+    static const uint8_t* moveTable(int move);
+
+    // Facelets a move changes (table[i] != i), count stored in count
+    static const uint8_t* movedFacelets(int move, int& count);
+
+    // Zobrist key of a colour on a facelet index. A fixed mix of the pair rather
+    // than a random table, so NxNCubeState can hash any size the same way and a
+    // 3x3 NxNCubeState hashes equal to the matching CubeState.
+    static uint64_t zobristKey(uint32_t index, int color) {
+        // SplitMix64 finaliser
+        uint64_t z = ((uint64_t)index * 8 + color + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif
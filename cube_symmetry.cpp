@@ -0,0 +1,152 @@
+#include "cube_symmetry.h"
+
+namespace {
+
+const int permutations[6][3] = {
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+};
+
+// Symmetry s sends axis a to axis permutations[s / 8][a], negated if bit a of s is set
+void transform(int symmetry, const int* v, int* out) {
+    const int* perm = permutations[symmetry / 8];
+    for (int a = 0; a < 3; a++) {
+        out[perm[a]] = (symmetry >> a) & 1 ? -v[a] : v[a];
+    }
+}
+
+struct SymmetryTables {
+    uint8_t facelets[CubeSymmetry::COUNT][CubeState::FACELET_COUNT];
+    uint8_t sources[CubeSymmetry::COUNT][CubeState::FACELET_COUNT];
+    uint8_t colors[CubeSymmetry::COUNT][6];
+    uint8_t inverses[CubeSymmetry::COUNT];
+    uint8_t moves[CubeSymmetry::COUNT][CubeState::MOVE_COUNT];
+    bool reflections[CubeSymmetry::COUNT];
+
+    SymmetryTables() {
+        for (int s = 0; s < CubeSymmetry::COUNT; s++) {
+            for (int face = 0; face < 6; face++) {
+                int normal[3];
+                transform(s, CubeState::faceNormal(face), normal);
+                colors[s][face] = (uint8_t)CubeState::faceFromNormal(normal);
+            }
+
+            for (int x = -1; x <= 1; x++) {
+                for (int y = -1; y <= 1; y++) {
+                    for (int z = -1; z <= 1; z++) {
+                        int p[3] = {x, y, z};
+                        int q[3];
+                        transform(s, p, q);
+                        for (int face = 0; face < 6; face++) {
+                            int from = CubeState::faceletAt(x, y, z, face);
+                            if (from < 0) continue;
+                            int to = CubeState::faceletAt(q[0], q[1], q[2], colors[s][face]);
+                            facelets[s][from] = (uint8_t)to;
+                            sources[s][to] = (uint8_t)from;
+                        }
+                    }
+                }
+            }
+
+            // Odd axis permutations and odd sign counts reverse handedness
+            int parity = (s / 8 == 1 || s / 8 == 2 || s / 8 == 5) ? 1 : 0;
+            parity ^= (s & 1) ^ ((s >> 1) & 1) ^ ((s >> 2) & 1);
+            reflections[s] = parity != 0;
+        }
+
+        for (int s = 0; s < CubeSymmetry::COUNT; s++) {
+            for (int t = 0; t < CubeSymmetry::COUNT; t++) {
+                bool identity = true;
+                for (int i = 0; i < CubeState::FACELET_COUNT && identity; i++) {
+                    identity = facelets[t][facelets[s][i]] == i;
+                }
+                if (identity) inverses[s] = (uint8_t)t;
+            }
+
+            // The conjugate of a move is the move with the conjugated facelet permutation
+            for (int move = 0; move < CubeState::MOVE_COUNT; move++) {
+                const uint8_t* gather = CubeState::moveTable(move);
+                uint8_t conjugate[CubeState::FACELET_COUNT];
+                for (int i = 0; i < CubeState::FACELET_COUNT; i++) {
+                    conjugate[facelets[s][i]] = facelets[s][gather[i]];
+                }
+                for (int other = 0; other < CubeState::MOVE_COUNT; other++) {
+                    if (memcmp(conjugate, CubeState::moveTable(other), CubeState::FACELET_COUNT) == 0) {
+                        moves[s][move] = (uint8_t)other;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+};
+
+const SymmetryTables& tables() {
+    static const SymmetryTables symmetryTables;
+    return symmetryTables;
+}
+
+} // namespace
+
+CubeState CubeSymmetry::apply(const CubeState& state, int symmetry) {
+    const uint8_t* source = tables().sources[symmetry];
+    const uint8_t* color = tables().colors[symmetry];
+    uint8_t result[CubeState::FACELET_COUNT];
+    for (int j = 0; j < CubeState::FACELET_COUNT; j++) {
+        result[j] = color[state.facelet(source[j])];
+    }
+    CubeState out;
+    out.setFacelets(result);
+    return out;
+}
+
+CubeState CubeSymmetry::canonical(const CubeState& state, int* symmetry) {
+    const SymmetryTables& symmetryTables = tables();
+    const uint8_t* facelets = state.data();
+    uint8_t best[CubeState::FACELET_COUNT];
+    memcpy(best, facelets, sizeof(best));
+    int bestSymmetry = 0;
+
+    // Build each candidate only as far as it stays equal to the best so far;
+    // most symmetries lose within the first few facelets
+    for (int s = 1; s < COUNT; s++) {
+        const uint8_t* source = symmetryTables.sources[s];
+        const uint8_t* color = symmetryTables.colors[s];
+        int j = 0;
+        while (j < CubeState::FACELET_COUNT && color[facelets[source[j]]] == best[j]) j++;
+        if (j == CubeState::FACELET_COUNT || color[facelets[source[j]]] > best[j]) continue;
+        for (; j < CubeState::FACELET_COUNT; j++) {
+            best[j] = color[facelets[source[j]]];
+        }
+        bestSymmetry = s;
+    }
+
+    if (symmetry) *symmetry = bestSymmetry;
+    if (bestSymmetry == 0) return state;
+    CubeState result;
+    result.setFacelets(best);
+    return result;
+}
+
+int CubeSymmetry::inverse(int symmetry) {
+    return tables().inverses[symmetry];
+}
+
+int CubeSymmetry::conjugateMove(int move, int symmetry) {
+    return tables().moves[symmetry][move];
+}
+
+bool CubeSymmetry::isReflection(int symmetry) {
+    return tables().reflections[symmetry];
+}
+
+const uint8_t* CubeSymmetry::faceletMap(int symmetry) {
+    return tables().facelets[symmetry];
+}
+
+const uint8_t* CubeSymmetry::sourceFacelets(int symmetry) {
+    return tables().sources[symmetry];
+}
+
+const uint8_t* CubeSymmetry::colorMap(int symmetry) {
+    return tables().colors[symmetry];
+}
@@ -0,0 +1,38 @@
+#ifndef CUBE_SYMMETRY_H
+#define CUBE_SYMMETRY_H
+
+#include <cstdint>
+#include "cube_state.h"
+
+// The 48 symmetries of the cube (24 rotations, each optionally mirrored)
+// acting on CubeState by conjugation: the sticker on facelet i with colour c
+// moves to facelet faceletMap(s)[i] and becomes colour colorMap(s)[c]. Solved
+// stays solved, and applying a move then a symmetry equals applying the
+// symmetry then conjugateMove(move, s).
+//
+// Symmetry s is the signed axis permutation with permutation s / 8 and the
+// sign of axis a negated when bit a of s % 8 is set; symmetry 0 is the identity.
+// All maps are precomputed, so applying a symmetry is one 54-byte gather plus
+// a colour lookup.
+class CubeSymmetry {
+public:
+    static const int COUNT = 48;
+
+    static CubeState apply(const CubeState& state, int symmetry);
+
+    // Unique representative of the state's symmetry class: the least state
+    // (comparing facelets in index order) over all 48 symmetries. The symmetry
+    // that produced it is stored in symmetry if given.
+    static CubeState canonical(const CubeState& state, int* symmetry = nullptr);
+
+    static int inverse(int symmetry);
+    static int conjugateMove(int move, int symmetry);
+    static bool isReflection(int symmetry);
+
+    static const uint8_t* faceletMap(int symmetry);
+    // gather form of faceletMap: facelet j of the result comes from facelet sourceFacelets(s)[j]
+    static const uint8_t* sourceFacelets(int symmetry);
+    static const uint8_t* colorMap(int symmetry);
+};
+
+#endif
@@ -0,0 +1,344 @@
+#define GL_GLEXT_PROTOTYPES
+#include "cube_wall.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+#include "cube_renderer.h"
+#include "frame_stats.h"
+#include "shader_pipeline.h"
+
+CubeWall* cubeWall = nullptr;
+
+namespace {
+
+const float PITCH = 4.0f;              // grid spacing; a cube is 3 wide
+const float BOUNDING_RADIUS = 2.6f;    // body corner, sqrt(3) * 1.5
+const int BODY_COLOR = 6;              // palette entry after the six sticker colours
+const GLsizei INDEX_COUNT = 3 * 6;     // a quad per axis, two triangles each
+
+const GLuint CORNER = 0;
+const GLuint AXIS = 1;
+const GLuint INSTANCE = 2;
+
+// A convex cube shows at most one face per axis, the one towards the eye, so
+// the mesh is three quads on the positive faces and the vertex shader turns
+// each one half a turn (keeping its winding) onto the negative face when the
+// eye is on that side. The fragment shader finds the sticker under the pixel
+// from the face's 3x3 grid coordinates and looks its colour up in the texture
+// buffer, leaving a dark border around every sticker. Six triangles a cube
+// keep llvmpipe's per-triangle work small. Lighting as in ShaderPipeline.
+const char* vertexSource =
+    "#version 330 core\n"
+    "layout(location = 0) in vec3 corner;\n"
+    "layout(location = 1) in int axis;\n"
+    "layout(location = 2) in vec4 instance;\n"
+    "uniform mat4 viewProjection;\n"
+    "uniform vec3 lightDirection;\n"
+    "uniform vec3 eye;\n"
+    "uniform int axisFaces[6];\n"
+    "uniform vec3 faceColumns[6];\n"
+    "uniform vec3 faceRows[6];\n"
+    "out vec2 stickerGrid;\n"
+    "flat out int firstSticker;\n"
+    "out float shade;\n"
+    "void main() {\n"
+    "    vec3 position = corner;\n"
+    "    int negative = eye[axis] < instance[axis] ? 1 : 0;\n"
+    "    if (negative == 1) {\n"
+    "        int other = (axis + 2) % 3;\n"
+    "        position[axis] = -position[axis];\n"
+    "        position[other] = -position[other];\n"
+    "    }\n"
+    "    int face = axisFaces[axis * 2 + negative];\n"
+    "    gl_Position = viewProjection * vec4(position + instance.xyz, 1.0);\n"
+    "    stickerGrid = vec2(dot(position, faceColumns[face]), dot(position, faceRows[face])) + 1.5;\n"
+    "    firstSticker = int(instance.w) * 54 + face * 9;\n"
+    "    vec3 normal = vec3(0.0);\n"
+    "    normal[axis] = negative == 1 ? -1.0 : 1.0;\n"
+    "    shade = 0.5 + 0.8 * max(dot(normal, lightDirection), 0.0);\n"
+    "}\n";
+
+const char* fragmentSource =
+    "#version 330 core\n"
+    "in vec2 stickerGrid;\n"
+    "flat in int firstSticker;\n"
+    "in float shade;\n"
+    "uniform vec3 palette[7];\n"
+    "uniform usamplerBuffer stickerColors;\n"
+    "out vec4 fragmentColor;\n"
+    "void main() {\n"
+    "    vec2 cell = clamp(floor(stickerGrid), vec2(0.0), vec2(2.0));\n"
+    "    vec2 inside = stickerGrid - cell;\n"
+    "    uint color = 6u;\n"
+    "    if (all(greaterThan(inside, vec2(0.06))) && all(lessThan(inside, vec2(0.94)))) {\n"
+    "        color = texelFetch(stickerColors, firstSticker + int(cell.y) * 3 + int(cell.x)).r;\n"
+    "    }\n"
+    "    fragmentColor = vec4(palette[color] * shade, 1.0);\n"
+    "}\n";
+
+struct WallVertex {
+    float corner[3];
+    GLint axis;
+};
+
+// The +x, +y and +z faces of a cube of width 3 centred at the origin, wound
+// counter-clockwise seen from outside, as two triangles each
+void buildMesh(std::vector<WallVertex>& vertices, std::vector<GLushort>& indices) {
+    const int corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    const GLushort triangles[6] = {0, 1, 2, 0, 2, 3};
+    for (int axis = 0; axis < 3; axis++) {
+        // (u, v, axis) is right-handed, so u then v runs counter-clockwise
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+        GLushort first = (GLushort)vertices.size();
+        for (int c = 0; c < 4; c++) {
+            WallVertex vertex;
+            vertex.corner[axis] = 1.5f;
+            vertex.corner[u] = 1.5f * corners[c][0];
+            vertex.corner[v] = 1.5f * corners[c][1];
+            vertex.axis = axis;
+            vertices.push_back(vertex);
+        }
+        for (int i = 0; i < 6; i++) indices.push_back((GLushort)(first + triangles[i]));
+    }
+}
+
+} // namespace
+
+CubeWall::CubeWall()
+    : columns(0), colorsDirty(false), visibleDirty(false), cameraChanges(0), program(0), vertexArray(0),
+      meshBuffer(0), indexBuffer(0), instanceBuffer(0), colorBuffer(0), colorTexture(0), viewProjectionLocation(-1),
+      lightDirectionLocation(-1), eyeLocation(-1), failed(false) {
+}
+
+CubeWall::~CubeWall() {
+    if (program) glDeleteProgram(program);
+    if (colorTexture) glDeleteTextures(1, &colorTexture);
+    if (meshBuffer) {
+        GLuint buffers[4] = {meshBuffer, indexBuffer, instanceBuffer, colorBuffer};
+        glDeleteBuffers(4, buffers);
+    }
+    if (vertexArray) glDeleteVertexArrays(1, &vertexArray);
+}
+
+void CubeWall::setStates(const std::vector<CubeState>& newStates) {
+    states = newStates;
+    columns = (int)std::ceil(std::sqrt((double)states.size()));
+    int rows = columns > 0 ? ((int)states.size() + columns - 1) / columns : 0;
+
+    grid.resize(states.size());
+    for (size_t i = 0; i < states.size(); i++) {
+        int column = (int)(i % columns);
+        int row = (int)(i / columns);
+        grid[i].x = (column - (columns - 1) * 0.5f) * PITCH;
+        grid[i].y = ((rows - 1) * 0.5f - row) * PITCH;
+        grid[i].z = 0.0f;
+        grid[i].state = (float)i;
+    }
+    colorsDirty = true;
+    cameraChanges = 0;  // cull again
+}
+
+float CubeWall::getWidth() const {
+    return columns * PITCH;
+}
+
+void CubeWall::fitCamera(Camera& camera) const {
+    // fitToSize leaves room for a spinning cube around its width; a flat wall
+    // fills the view at under half of that
+    camera.fitToSize(getWidth() * 0.45f);
+}
+
+bool CubeWall::createResources() {
+    program = ShaderPipeline::buildProgram(vertexSource, fragmentSource);
+    if (!program) return false;
+    viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+    lightDirectionLocation = glGetUniformLocation(program, "lightDirection");
+    eyeLocation = glGetUniformLocation(program, "eye");
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "stickerColors"), 0);
+    float palette[7 * 3];
+    for (int color = 0; color < 6; color++) {
+        const uint8_t* rgb = CubeRenderer::stickerColor(color);
+        for (int c = 0; c < 3; c++) palette[color * 3 + c] = rgb[c] / 255.0f;
+    }
+    for (int c = 0; c < 3; c++) palette[BODY_COLOR * 3 + c] = 0.05f;
+    glUniform3fv(glGetUniformLocation(program, "palette"), 7, palette);
+
+    // Face on each side of each axis, and the sticker grid directions of every face
+    GLint axisFaces[6];
+    float columns[6 * 3], rows[6 * 3];
+    for (int axis = 0; axis < 3; axis++) {
+        for (int negative = 0; negative < 2; negative++) {
+            int normal[3] = {0, 0, 0};
+            normal[axis] = negative ? -1 : 1;
+            axisFaces[axis * 2 + negative] = CubeState::faceFromNormal(normal);
+        }
+    }
+    for (int face = 0; face < 6; face++) {
+        for (int a = 0; a < 3; a++) {
+            columns[face * 3 + a] = (float)CubeState::faceColumnAxis(face)[a];
+            rows[face * 3 + a] = (float)CubeState::faceRowAxis(face)[a];
+        }
+    }
+    glUniform1iv(glGetUniformLocation(program, "axisFaces"), 6, axisFaces);
+    glUniform3fv(glGetUniformLocation(program, "faceColumns"), 6, columns);
+    glUniform3fv(glGetUniformLocation(program, "faceRows"), 6, rows);
+
+    std::vector<WallVertex> vertices;
+    std::vector<GLushort> indices;
+    buildMesh(vertices, indices);
+
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    GLuint buffers[4];
+    glGenBuffers(4, buffers);
+    meshBuffer = buffers[0];
+    indexBuffer = buffers[1];
+    instanceBuffer = buffers[2];
+    colorBuffer = buffers[3];
+
+    glBindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(WallVertex), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(CORNER);
+    glVertexAttribPointer(CORNER, 3, GL_FLOAT, GL_FALSE, sizeof(WallVertex), (const void*)0);
+    glEnableVertexAttribArray(AXIS);
+    glVertexAttribIPointer(AXIS, 1, GL_INT, sizeof(WallVertex), (const void*)(3 * sizeof(float)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(INSTANCE);
+    glVertexAttribPointer(INSTANCE, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void*)0);
+    glVertexAttribDivisor(INSTANCE, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+
+    glGenTextures(1, &colorTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, colorTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, colorBuffer);
+    return true;
+}
+
+void CubeWall::cull(const Camera& camera) {
+    // Frustum planes straight from the rows of the view-projection matrix
+    // (column-major): w + x, w - x, w + y, w - y, w + z, w - z >= 0
+    const float* m = camera.getViewProjectionMatrix();
+    float planes[6][4];
+    for (int p = 0; p < 6; p++) {
+        int row = p / 2;
+        float sign = p % 2 == 0 ? 1.0f : -1.0f;
+        float length = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            planes[p][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+            if (c < 3) length += planes[p][c] * planes[p][c];
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < 4; c++) planes[p][c] /= length;
+    }
+
+    size_t previous = visible.size();
+    size_t kept = 0;
+    bool changed = false;
+    visible.resize(grid.size());
+    for (size_t i = 0; i < grid.size(); i++) {
+        const Instance& cube = grid[i];
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++) {
+            inside = planes[p][0] * cube.x + planes[p][1] * cube.y + planes[p][2] * cube.z + planes[p][3] >
+                     -BOUNDING_RADIUS;
+        }
+        if (!inside) continue;
+        // Same cube in the same slot as last time leaves the buffer alone
+        if (kept >= previous || visible[kept].state != cube.state) changed = true;
+        visible[kept++] = cube;
+    }
+    visible.resize(kept);
+    if (changed || kept != previous) visibleDirty = true;
+}
+
+void CubeWall::draw(const Camera& camera) {
+    if (failed || states.empty()) return;
+    if (!program && !createResources()) {
+        fprintf(stderr, "Cube wall unavailable\n");
+        failed = true;
+        return;
+    }
+    glUseProgram(program);
+    glBindVertexArray(vertexArray);
+
+    if (colorsDirty) {
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        if ((double)states.size() * CubeState::FACELET_COUNT > (double)maxTexels) {
+            fprintf(stderr, "Cube wall: %zu states exceed the texture buffer limit of %d stickers\n",
+                    states.size(), maxTexels);
+            failed = true;
+            return;
+        }
+        std::vector<uint8_t> colors(states.size() * CubeState::FACELET_COUNT);
+        for (size_t i = 0; i < states.size(); i++) {
+            memcpy(&colors[i * CubeState::FACELET_COUNT], states[i].data(), CubeState::FACELET_COUNT);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, colorBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, colors.size(), colors.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, colorTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, colorBuffer);
+        colorsDirty = false;
+    }
+
+    if (camera.getChanges() != cameraChanges) {
+        cameraChanges = camera.getChanges();
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, camera.getViewProjectionMatrix());
+        float light[3];
+        ShaderPipeline::lightDirection(camera, light);
+        glUniform3fv(lightDirectionLocation, 1, light);
+        // Eye position from the view matrix: -R^T t
+        const float* view = camera.getViewMatrix();
+        float eye[3];
+        for (int a = 0; a < 3; a++) {
+            eye[a] = -(view[a * 4] * view[12] + view[a * 4 + 1] * view[13] + view[a * 4 + 2] * view[14]);
+        }
+        glUniform3fv(eyeLocation, 1, eye);
+        cull(camera);
+    }
+    if (visibleDirty) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, visible.size() * sizeof(Instance), visible.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        visibleDirty = false;
+    }
+    if (visible.empty()) return;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, colorTexture);
+    // A face whose plane the eye is inside of shows its back; skip it
+    glEnable(GL_CULL_FACE);
+    glDrawElementsInstanced(GL_TRIANGLES, INDEX_COUNT, GL_UNSIGNED_SHORT, (const void*)0, (GLsizei)visible.size());
+    glDisable(GL_CULL_FACE);
+    countDrawCall((long)INDEX_COUNT * (long)visible.size());
+}
+
+std::vector<CubeState> CubeWall::statesAtDepth(const CubeState& from, int depth, size_t limit) {
+    std::vector<CubeState> frontier(1, from);
+    std::unordered_set<uint64_t> seen;
+    seen.insert(from.hash());
+    for (int d = 0; d < depth && !frontier.empty(); d++) {
+        std::vector<CubeState> next;
+        for (size_t i = 0; i < frontier.size(); i++) {
+            for (int move = 0; move < CubeState::MOVE_COUNT; move++) {
+                if (CubeState::moveOffset(move) == 0) continue;  // slices are not face turns
+                CubeState turned = frontier[i];
+                turned.applyMove(move);
+                if (!seen.insert(turned.hash()).second) continue;
+                next.push_back(turned);
+                if (d == depth - 1 && next.size() >= limit) return next;
+            }
+        }
+        frontier.swap(next);
+    }
+    if (frontier.size() > limit) frontier.resize(limit);
+    return frontier;
+}
@@ -0,0 +1,78 @@
+#ifndef CUBE_WALL_H
+#define CUBE_WALL_H
+
+#include <GL/glut.h>
+#include <cstddef>
+#include <vector>
+#include "camera.h"
+#include "cube_state.h"
+
+// Many 3x3 states at once, e.g. every position two turns from the current
+// one, laid out as a square grid in the XY plane around the origin.
+//
+// Every cube is the same mesh (the three faces towards the eye, stickers
+// drawn by the fragment shader) drawn with one instanced call. Per instance
+// only a grid offset and a state index go to the GPU; the sticker colours of
+// all states sit in one texture buffer (one byte per sticker) that the
+// fragment shader reads. Cubes outside the camera frustum
+// are dropped on the CPU with a bounding-sphere test, redone only when the
+// camera moved, and the instance buffer is rewritten only when the visible
+// set changed. A still frame is one draw call however many cubes there are.
+//
+// Needs the core-profile ShaderPipeline; buffers are created on the first draw.
+class CubeWall {
+public:
+    CubeWall();
+    ~CubeWall();
+
+    // Show these states, row by row from the top left
+    void setStates(const std::vector<CubeState>& newStates);
+    size_t size() const { return states.size(); }
+    float getWidth() const;
+
+    // Zoom the camera out until the whole wall is in view
+    void fitCamera(Camera& camera) const;
+
+    // Cubes that passed the frustum test in the last draw
+    size_t visibleCount() const { return visible.size(); }
+
+    void draw(const Camera& camera);
+
+    // The distinct states exactly depth outer-face turns (quarter or half)
+    // from 'from', in breadth-first order, at most limit of them
+    static std::vector<CubeState> statesAtDepth(const CubeState& from, int depth, size_t limit);
+
+private:
+    struct Instance {
+        float x, y, z;
+        float state;  // index into the colour buffer, exact as a float below 2^24
+    };
+
+    std::vector<CubeState> states;
+    std::vector<Instance> grid;      // every cube's instance, in state order
+    std::vector<Instance> visible;   // the ones inside the frustum
+    int columns;
+    bool colorsDirty;
+    bool visibleDirty;
+    unsigned cameraChanges;
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint meshBuffer;
+    GLuint indexBuffer;
+    GLuint instanceBuffer;
+    GLuint colorBuffer;
+    GLuint colorTexture;
+    GLint viewProjectionLocation;
+    GLint lightDirectionLocation;
+    GLint eyeLocation;
+    bool failed;  // shaders or buffers unavailable; draw does nothing
+
+    bool createResources();
+    void cull(const Camera& camera);
+};
+
+// Shown instead of the cube while set (W key), otherwise null
+extern CubeWall* cubeWall;
+
+#endif
@@ -0,0 +1,303 @@
+#include "cubie_cube.h"
+
+namespace {
+
+// Home positions (x, y, z in -1..1) of the corners and edges
+const int cornerPosition[8][3] = {
+    { 1,  1,  1}, {-1,  1,  1}, {-1,  1, -1}, { 1,  1, -1},
+    { 1, -1,  1}, {-1, -1,  1}, {-1, -1, -1}, { 1, -1, -1}
+};
+const int edgePosition[12][3] = {
+    { 1,  1,  0}, { 0,  1,  1}, {-1,  1,  0}, { 0,  1, -1},
+    { 1, -1,  0}, { 0, -1,  1}, {-1, -1,  0}, { 0, -1, -1},
+    { 1,  0,  1}, {-1,  0,  1}, {-1,  0, -1}, { 1,  0, -1}
+};
+
+int xFace(int x) { return x > 0 ? FACE_RIGHT : FACE_LEFT; }
+int yFace(int y) { return y > 0 ? FACE_TOP : FACE_BOTTOM; }
+int zFace(int z) { return z > 0 ? FACE_FRONT : FACE_BACK; }
+
+// Facelets of every corner and edge position. Corners start with the top/bottom
+// sticker and go clockwise seen from outside; edges start with the top/bottom
+// sticker, or the front/back one for middle layer edges.
+struct PieceFacelets {
+    int cornerFace[8][3];
+    int cornerFacelet[8][3];
+    int edgeFace[12][2];
+    int edgeFacelet[12][2];
+
+    PieceFacelets() {
+        for (int i = 0; i < 8; i++) {
+            const int* p = cornerPosition[i];
+            cornerFace[i][0] = yFace(p[1]);
+            if (p[0] * p[1] * p[2] > 0) {
+                cornerFace[i][1] = xFace(p[0]);
+                cornerFace[i][2] = zFace(p[2]);
+            } else {
+                cornerFace[i][1] = zFace(p[2]);
+                cornerFace[i][2] = xFace(p[0]);
+            }
+            for (int k = 0; k < 3; k++) {
+                cornerFacelet[i][k] = CubeState::faceletAt(p[0], p[1], p[2], cornerFace[i][k]);
+            }
+        }
+        for (int i = 0; i < 12; i++) {
+            const int* p = edgePosition[i];
+            if (p[1] != 0) {
+                edgeFace[i][0] = yFace(p[1]);
+                edgeFace[i][1] = p[0] != 0 ? xFace(p[0]) : zFace(p[2]);
+            } else {
+                edgeFace[i][0] = zFace(p[2]);
+                edgeFace[i][1] = xFace(p[0]);
+            }
+            for (int k = 0; k < 2; k++) {
+                edgeFacelet[i][k] = CubeState::faceletAt(p[0], p[1], p[2], edgeFace[i][k]);
+            }
+        }
+    }
+};
+
+const PieceFacelets& pieceFacelets() {
+    static const PieceFacelets facelets;
+    return facelets;
+}
+
+struct FaceMoveCubes {
+    CubieCube moves[FACE_MOVE_COUNT];
+
+    FaceMoveCubes() {
+        for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+            CubeState state;
+            state.applyMove(faceMoveToStateMove(m));
+            moves[m].fromState(state);
+        }
+    }
+};
+
+int permutationParity(const uint8_t* perm, int n) {
+    int parity = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            if (perm[j] < perm[i]) parity ^= 1;
+        }
+    }
+    return parity;
+}
+
+} // namespace
+
+CubieCube::CubieCube() {
+    for (int i = 0; i < 8; i++) {
+        cp[i] = (uint8_t)i;
+        co[i] = 0;
+    }
+    for (int i = 0; i < 12; i++) {
+        ep[i] = (uint8_t)i;
+        eo[i] = 0;
+    }
+}
+
+bool CubieCube::fromState(const CubeState& state) {
+    const PieceFacelets& pf = pieceFacelets();
+
+    // Map each colour to the face whose centre shows it
+    int colorFace[6] = {-1, -1, -1, -1, -1, -1};
+    for (int f = 0; f < 6; f++) {
+        int color = state.facelet(f * 9 + 4);
+        if (color > 5 || colorFace[color] != -1) return false;
+        colorFace[color] = f;
+    }
+
+    bool cornerSeen[8] = {false};
+    int twistSum = 0;
+    for (int i = 0; i < 8; i++) {
+        int face[3];
+        for (int k = 0; k < 3; k++) {
+            int color = state.facelet(pf.cornerFacelet[i][k]);
+            if (color > 5) return false;
+            face[k] = colorFace[color];
+        }
+        int ori = 0;
+        while (ori < 3 && face[ori] != FACE_TOP && face[ori] != FACE_BOTTOM) ori++;
+        if (ori == 3) return false;
+
+        int piece = -1;
+        for (int j = 0; j < 8; j++) {
+            if (pf.cornerFace[j][0] == face[ori] &&
+                pf.cornerFace[j][1] == face[(ori + 1) % 3] &&
+                pf.cornerFace[j][2] == face[(ori + 2) % 3]) {
+                piece = j;
+                break;
+            }
+        }
+        if (piece < 0 || cornerSeen[piece]) return false;
+        cornerSeen[piece] = true;
+        cp[i] = (uint8_t)piece;
+        co[i] = (uint8_t)ori;
+        twistSum += ori;
+    }
+
+    bool edgeSeen[12] = {false};
+    int flipSum = 0;
+    for (int i = 0; i < 12; i++) {
+        int color0 = state.facelet(pf.edgeFacelet[i][0]);
+        int color1 = state.facelet(pf.edgeFacelet[i][1]);
+        if (color0 > 5 || color1 > 5) return false;
+        int face0 = colorFace[color0];
+        int face1 = colorFace[color1];
+
+        int piece = -1;
+        int ori = 0;
+        for (int j = 0; j < 12; j++) {
+            if (pf.edgeFace[j][0] == face0 && pf.edgeFace[j][1] == face1) {
+                piece = j;
+                ori = 0;
+                break;
+            }
+            if (pf.edgeFace[j][0] == face1 && pf.edgeFace[j][1] == face0) {
+                piece = j;
+                ori = 1;
+                break;
+            }
+        }
+        if (piece < 0 || edgeSeen[piece]) return false;
+        edgeSeen[piece] = true;
+        ep[i] = (uint8_t)piece;
+        eo[i] = (uint8_t)ori;
+        flipSum += ori;
+    }
+
+    return twistSum % 3 == 0 && flipSum % 2 == 0 &&
+           permutationParity(cp, 8) == permutationParity(ep, 12);
+}
+
+void CubieCube::multiply(const CubieCube& other) {
+    uint8_t newCp[8], newCo[8], newEp[12], newEo[12];
+    for (int i = 0; i < 8; i++) {
+        newCp[i] = cp[other.cp[i]];
+        newCo[i] = (uint8_t)((co[other.cp[i]] + other.co[i]) % 3);
+    }
+    for (int i = 0; i < 12; i++) {
+        newEp[i] = ep[other.ep[i]];
+        newEo[i] = (uint8_t)((eo[other.ep[i]] + other.eo[i]) % 2);
+    }
+    for (int i = 0; i < 8; i++) {
+        cp[i] = newCp[i];
+        co[i] = newCo[i];
+    }
+    for (int i = 0; i < 12; i++) {
+        ep[i] = newEp[i];
+        eo[i] = newEo[i];
+    }
+}
+
+bool CubieCube::isSolved() const {
+    for (int i = 0; i < 8; i++) {
+        if (cp[i] != i || co[i] != 0) return false;
+    }
+    for (int i = 0; i < 12; i++) {
+        if (ep[i] != i || eo[i] != 0) return false;
+    }
+    return true;
+}
+
+int CubieCube::cornerPermutation() const {
+    return rankPermutation(cp, 8);
+}
+
+int CubieCube::twist() const {
+    int result = 0;
+    for (int i = 0; i < 7; i++) {
+        result = result * 3 + co[i];
+    }
+    return result;
+}
+
+int CubieCube::flip() const {
+    int result = 0;
+    for (int i = 0; i < 11; i++) {
+        result = result * 2 + eo[i];
+    }
+    return result;
+}
+
+void CubieCube::setCornerPermutation(int index) {
+    unrankPermutation(index, cp, 8);
+}
+
+void CubieCube::setTwist(int index) {
+    int sum = 0;
+    for (int i = 6; i >= 0; i--) {
+        co[i] = (uint8_t)(index % 3);
+        sum += co[i];
+        index /= 3;
+    }
+    co[7] = (uint8_t)((3 - sum % 3) % 3);
+}
+
+void CubieCube::setFlip(int index) {
+    int sum = 0;
+    for (int i = 10; i >= 0; i--) {
+        eo[i] = (uint8_t)(index % 2);
+        sum += eo[i];
+        index /= 2;
+    }
+    eo[11] = (uint8_t)(sum % 2);
+}
+
+const CubieCube& faceMoveCube(int faceMove) {
+    static const FaceMoveCubes cubes;
+    return cubes.moves[faceMove];
+}
+
+int faceMoveToStateMove(int faceMove) {
+    // Layer (axis, offset) of each face and the CubeState turn that is
+    // clockwise when looking at that face
+    static const int faceAxis[6] = {1, 0, 2, 1, 0, 2};
+    static const int faceOffset[6] = {1, 1, 1, -1, -1, -1};
+    static const int faceClockwiseTurn[6] = {2, 0, 0, 0, 2, 2};
+
+    int face = faceMove / 3;
+    int power = faceMove % 3 + 1;
+    int turn;
+    if (power == 1) {
+        turn = faceClockwiseTurn[face];
+    } else if (power == 2) {
+        turn = 1;
+    } else {
+        turn = 2 - faceClockwiseTurn[face];
+    }
+    return CubeState::layerIndex(faceAxis[face], faceOffset[face]) * 3 + turn;
+}
+
+int rankPermutation(const uint8_t* perm, int n) {
+    int rank = 0;
+    for (int i = 0; i < n; i++) {
+        int smaller = 0;
+        for (int j = i + 1; j < n; j++) {
+            if (perm[j] < perm[i]) smaller++;
+        }
+        rank = rank * (n - i) + smaller;
+    }
+    return rank;
+}
+
+void unrankPermutation(int index, uint8_t* perm, int n) {
+    int digits[12];
+    for (int i = n - 1; i >= 0; i--) {
+        digits[i] = index % (n - i);
+        index /= (n - i);
+    }
+    uint8_t available[12];
+    for (int i = 0; i < n; i++) {
+        available[i] = (uint8_t)i;
+    }
+    int remaining = n;
+    for (int i = 0; i < n; i++) {
+        perm[i] = available[digits[i]];
+        for (int k = digits[i]; k < remaining - 1; k++) {
+            available[k] = available[k + 1];
+        }
+        remaining--;
+    }
+}
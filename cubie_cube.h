@@ -0,0 +1,54 @@
+#ifndef CUBIE_CUBE_H
+#define CUBIE_CUBE_H
+
+#include <cstdint>
+#include "cube_state.h"
+
+// Corner and edge positions in the usual solver order
+// (U = top, D = bottom, F = front, B = back, L = left, R = right).
+enum Corner { URF = 0, UFL, ULB, UBR, DFR, DLF, DBL, DRB };
+enum Edge { UR = 0, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR };
+
+// Solver face moves: face * 3 + power - 1, faces in U R F D L B order and
+// power 1 = clockwise looking at that face, 2 = half turn, 3 = counter-clockwise.
+const int FACE_MOVE_COUNT = 18;
+
+// Cube on the cubie level: cp[i]/ep[i] is the piece at position i and
+// co[i]/eo[i] its orientation. Used by the solvers, not by the renderer.
+struct CubieCube {
+    uint8_t cp[8];
+    uint8_t co[8];
+    uint8_t ep[12];
+    uint8_t eo[12];
+
+    CubieCube(); // solved
+
+    // Read the pieces from a facelet state. Colours are matched against the
+    // centres, so states after slice moves work too. Returns false if the
+    // stickers do not describe a reachable cube.
+    bool fromState(const CubeState& state);
+
+    // this = this followed by other
+    void multiply(const CubieCube& other);
+    bool isSolved() const;
+
+    // Coordinates
+    int cornerPermutation() const;   // 0..40319
+    int twist() const;               // 0..2186
+    int flip() const;                // 0..2047
+    void setCornerPermutation(int index);
+    void setTwist(int index);
+    void setFlip(int index);
+};
+
+// Cubie-level effect of each solver face move
+const CubieCube& faceMoveCube(int faceMove);
+
+// The CubeState layer move that performs a solver face move
+int faceMoveToStateMove(int faceMove);
+
+// Lehmer rank of a permutation of 0..n-1 and its inverse
+int rankPermutation(const uint8_t* perm, int n);
+void unrankPermutation(int index, uint8_t* perm, int n);
+
+#endif
@@ -0,0 +1,245 @@
+#define GL_GLEXT_PROTOTYPES
+#include "frame_stats.h"
+#include "shader_pipeline.h"
+#include <algorithm>
+#include <cstring>
+
+FrameStats* frameStats = nullptr;
+
+namespace {
+
+double millisecondsBetween(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+const char* stageNames[FrameStats::STAGE_COUNT] = {"camera", "animation", "draw", "swap"};
+
+void drawText(int x, int y, const char* text) {
+    glRasterPos2i(x, y);
+    for (const char* c = text; *c; c++) {
+        glutBitmapCharacter(GLUT_BITMAP_8_BY_13, *c);
+    }
+}
+
+} // namespace
+
+FrameStats::FrameStats()
+    : overlayVisible(false), csv(nullptr), recording(false), frameNumber(0),
+      timerChecked(false), timerQueries(false), sampleCount(0), sampleNext(0),
+      lastDrawCalls(0), lastVertices(0), totalDrawCalls(0), totalVertices(0) {
+    memset(&current, 0, sizeof(current));
+    memset(queries, 0, sizeof(queries));
+    for (int i = 0; i < QUERY_LATENCY; i++) {
+        inFlight[i].pending = false;
+    }
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        samples[m].assign(WINDOW, -1.0);
+    }
+}
+
+FrameStats::~FrameStats() {
+    // Write out the frames still waiting for their GPU time
+    for (unsigned long long f = frameNumber; f < frameNumber + QUERY_LATENCY; f++) {
+        resolve((int)(f % QUERY_LATENCY), true);
+    }
+    if (timerQueries) {
+        glDeleteQueries(QUERY_LATENCY, queries);
+    }
+    if (csv) {
+        fclose(csv);
+    }
+}
+
+bool FrameStats::openCsv(const std::string& path) {
+    if (csv) fclose(csv);
+    csv = fopen(path.c_str(), "w");
+    if (!csv) return false;
+    fprintf(csv, "frame,interval_ms");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        fprintf(csv, ",%s_ms", stageNames[s]);
+    }
+    fprintf(csv, ",cpu_ms,gpu_ms,draw_calls,vertices\n");
+    return true;
+}
+
+// Timer queries need GL 3.3 or ARB_timer_query, and a current context
+void FrameStats::checkTimerQueries() {
+    timerChecked = true;
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (version) sscanf(version, "%d.%d", &major, &minor);
+    timerQueries = major > 3 || (major == 3 && minor >= 3);
+    if (!timerQueries) {
+        // Only asked for below 3.3: a core profile has no GL_EXTENSIONS string
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        timerQueries = extensions && strstr(extensions, "GL_ARB_timer_query");
+    }
+    if (timerQueries) {
+        glGenQueries(QUERY_LATENCY, queries);
+    }
+}
+
+void FrameStats::beginFrame() {
+    recording = isEnabled();
+    if (!recording) return;
+    if (!timerChecked) checkTimerQueries();
+
+    // The query slot we are about to reuse belongs to an old frame; finish it
+    int slot = (int)(frameNumber % QUERY_LATENCY);
+    resolve(slot, true);
+
+    Clock::time_point now = Clock::now();
+    memset(&current, 0, sizeof(current));
+    current.frame = frameNumber;
+    current.intervalMs = frameNumber > 0 ? millisecondsBetween(lastFrameStart, now) : 0.0;
+    lastFrameStart = now;
+    frameStart = stageStart = now;
+
+    if (timerQueries) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+    }
+}
+
+void FrameStats::endStage(Stage stage) {
+    if (!recording) return;
+    Clock::time_point now = Clock::now();
+    current.stageMs[stage] += millisecondsBetween(stageStart, now);
+    stageStart = now;
+}
+
+void FrameStats::addDrawCall(long vertices) {
+    totalDrawCalls++;
+    totalVertices += vertices;
+    if (!recording) return;
+    current.drawCalls++;
+    current.vertices += vertices;
+}
+
+void FrameStats::endFrame() {
+    if (!recording) return;
+    endStage(STAGE_SWAP);
+    current.cpuMs = millisecondsBetween(frameStart, Clock::now());
+    current.pending = true;
+
+    int slot = (int)(frameNumber % QUERY_LATENCY);
+    inFlight[slot] = current;
+    if (!timerQueries) {
+        resolve(slot, false);
+    }
+    frameNumber++;
+    recording = false;
+}
+
+// Read the GPU time of the frame in a slot (waiting for it if asked), then
+// add the frame to the window and the CSV file
+void FrameStats::resolve(int slot, bool wait) {
+    FrameRecord& record = inFlight[slot];
+    if (!record.pending) return;
+
+    double gpuMs = -1.0;
+    if (timerQueries) {
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && !wait) return;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+        // llvmpipe reports nonsense for the first query of a context
+        gpuMs = record.frame > 0 ? elapsed / 1e6 : -1.0;
+    }
+    finishRecord(record, gpuMs);
+}
+
+void FrameStats::finishRecord(FrameRecord& record, double gpuMs) {
+    record.pending = false;
+
+    samples[METRIC_INTERVAL][sampleNext] = record.frame > 0 ? record.intervalMs : -1.0;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        samples[METRIC_STAGE + s][sampleNext] = record.stageMs[s];
+    }
+    samples[METRIC_CPU][sampleNext] = record.cpuMs;
+    samples[METRIC_GPU][sampleNext] = gpuMs;
+    sampleNext = (sampleNext + 1) % WINDOW;
+    if (sampleCount < WINDOW) sampleCount++;
+    lastDrawCalls = record.drawCalls;
+    lastVertices = record.vertices;
+
+    if (csv) {
+        fprintf(csv, "%llu,%.4f", record.frame, record.intervalMs);
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            fprintf(csv, ",%.4f", record.stageMs[s]);
+        }
+        fprintf(csv, ",%.4f,%.4f,%d,%ld\n", record.cpuMs, gpuMs, record.drawCalls, record.vertices);
+    }
+}
+
+// Percentile of a metric over the window, ignoring missing samples; -1 if none
+double FrameStats::percentile(int metric, double fraction) const {
+    sorted.clear();
+    for (int i = 0; i < sampleCount; i++) {
+        if (samples[metric][i] >= 0.0) sorted.push_back(samples[metric][i]);
+    }
+    if (sorted.empty()) return -1.0;
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void FrameStats::drawOverlay() {
+    if (!recording) return;
+    if (timerQueries) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    // The text is drawn with the fixed-function raster position, which a core
+    // profile lacks; timing and the CSV still work there
+    if (!overlayVisible || shaderPipeline) return;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, viewport[2], 0, viewport[3], -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    char line[128];
+    int y = viewport[3] - 18;
+    glColor3f(1.0f, 1.0f, 1.0f);
+
+    double interval = percentile(METRIC_INTERVAL, 0.5);
+    snprintf(line, sizeof(line), "frame   p50 %6.2f ms  p99 %6.2f ms  (%.0f fps)",
+             interval, percentile(METRIC_INTERVAL, 0.99), interval > 0.0 ? 1000.0 / interval : 0.0);
+    drawText(10, y, line);
+    y -= 15;
+    snprintf(line, sizeof(line), "cpu     p50 %6.2f ms  p99 %6.2f ms",
+             percentile(METRIC_CPU, 0.5), percentile(METRIC_CPU, 0.99));
+    drawText(10, y, line);
+    y -= 15;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        snprintf(line, sizeof(line), " %-9s p50 %6.3f ms  p99 %6.3f ms", stageNames[s],
+                 percentile(METRIC_STAGE + s, 0.5), percentile(METRIC_STAGE + s, 0.99));
+        drawText(10, y, line);
+        y -= 15;
+    }
+    if (timerQueries) {
+        snprintf(line, sizeof(line), "gpu     p50 %6.2f ms  p99 %6.2f ms",
+                 percentile(METRIC_GPU, 0.5), percentile(METRIC_GPU, 0.99));
+    } else {
+        snprintf(line, sizeof(line), "gpu     no timer queries");
+    }
+    drawText(10, y, line);
+    y -= 15;
+    snprintf(line, sizeof(line), "draws %d  vertices %ld", lastDrawCalls, lastVertices);
+    drawText(10, y, line);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
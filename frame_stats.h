@@ -0,0 +1,115 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <GL/glut.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Optional per-frame instrumentation.
+//
+// display() brackets each stage (camera, animation, cube draw, buffer swap)
+// and the renderer reports its draw calls and vertices. GPU time comes from
+// GL_TIME_ELAPSED queries when the driver has timer queries; results are read
+// a few frames late so the CPU never waits on them. A rolling window gives the
+// p50/p99 shown in the overlay, and every frame can be streamed to a CSV file.
+// Nothing is measured while the overlay is hidden and no CSV file is open.
+class FrameStats {
+public:
+    enum Stage {
+        STAGE_CAMERA = 0,
+        STAGE_ANIMATION,
+        STAGE_DRAW,
+        STAGE_SWAP,
+        STAGE_COUNT
+    };
+
+    FrameStats();
+    ~FrameStats();
+
+    bool openCsv(const std::string& path);
+    void setOverlayVisible(bool visible) { overlayVisible = visible; }
+    void toggleOverlay() { overlayVisible = !overlayVisible; }
+    bool isOverlayVisible() const { return overlayVisible; }
+    bool isEnabled() const { return overlayVisible || csv != nullptr; }
+
+    // Frame bracketing, in display() order
+    void beginFrame();
+    void endStage(Stage stage);
+    void drawOverlay();     // ends the GPU query, then draws the overlay if visible
+    void endFrame();        // after the buffer swap
+
+    void addDrawCall(long vertices);
+
+    // Draw calls and vertices since creation, counted even while nothing is
+    // measured (for benchmarks that time frames themselves)
+    unsigned long long getTotalDrawCalls() const { return totalDrawCalls; }
+    unsigned long long getTotalVertices() const { return totalVertices; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int WINDOW = 240;         // frames in the rolling percentiles
+    static const int QUERY_LATENCY = 4;    // frames before a GPU result is read
+
+    struct FrameRecord {
+        unsigned long long frame;
+        double intervalMs;
+        double stageMs[STAGE_COUNT];
+        double cpuMs;
+        int drawCalls;
+        long vertices;
+        bool pending;
+    };
+
+    bool overlayVisible;
+    FILE* csv;
+    bool recording;                        // this frame is being measured
+    unsigned long long frameNumber;
+    Clock::time_point frameStart;
+    Clock::time_point stageStart;
+    Clock::time_point lastFrameStart;
+    FrameRecord current;
+
+    // Timer queries, one per frame in flight
+    bool timerChecked;
+    bool timerQueries;
+    GLuint queries[QUERY_LATENCY];
+    FrameRecord inFlight[QUERY_LATENCY];
+
+    // Rolling samples per metric: frame interval, stages, CPU total, GPU
+    // (negative = no GPU result)
+    enum {
+        METRIC_INTERVAL = 0,
+        METRIC_STAGE,
+        METRIC_CPU = METRIC_STAGE + STAGE_COUNT,
+        METRIC_GPU,
+        METRIC_COUNT
+    };
+    std::vector<double> samples[METRIC_COUNT];
+    int sampleCount;
+    int sampleNext;
+    int lastDrawCalls;
+    long lastVertices;
+    unsigned long long totalDrawCalls;
+    unsigned long long totalVertices;
+    mutable std::vector<double> sorted;
+
+    void checkTimerQueries();
+    void finishRecord(FrameRecord& record, double gpuMs);
+    void resolve(int slot, bool wait);
+    double percentile(int metric, double fraction) const;
+};
+
+// Global frame statistics, created in main
+extern FrameStats* frameStats;
+
+// Report one draw call to the frame statistics, if any
+inline void countDrawCall(long vertices) {
+    if (frameStats) {
+        frameStats->addDrawCall(vertices);
+    }
+}
+
+#endif
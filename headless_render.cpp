@@ -0,0 +1,613 @@
+#define GL_GLEXT_PROTOTYPES
+#include "headless_render.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <png.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "algorithm.h"
+#include "cube.h"
+#include "cube_wall.h"
+#include "frame_stats.h"
+#include "input_handler.h"
+#include "input_log.h"
+#include "shader_pipeline.h"
+
+using namespace std;
+
+// Scene setup shared with the window, defined in main.cpp
+extern void initGL();
+extern void reshape(int w, int h);
+
+namespace {
+
+struct RenderOptions {
+    string moves;
+    string outDir;
+    string format;
+    int width;
+    int height;
+    int framesPerTurn;
+    int size;
+    bool core;
+    bool standard;
+    size_t wall;       // cubes in the wall, 0 for the single cube
+    int wallFrames;    // frames of one orbit around the wall
+
+    RenderOptions()
+        : outDir("frames"), format("png"), width(800), height(600), framesPerTurn(15), size(3), core(false),
+          standard(false), wall(0), wallFrames(120) {}
+};
+
+// Surfaceless EGL context with a desktop GL API: compatibility, or 3.3 core
+struct OffscreenContext {
+    EGLDisplay display;
+    EGLContext context;
+    GLuint framebuffer;
+    GLuint renderbuffers[2];
+
+    OffscreenContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT), framebuffer(0) {}
+
+    bool create(int width, int height, bool core) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            fprintf(stderr, "Cannot initialise EGL\n");
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            fprintf(stderr, "EGL has no desktop OpenGL\n");
+            return false;
+        }
+
+        EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLConfig config = nullptr;
+        EGLint configCount = 0;
+        eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+        EGLint coreAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                   EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+        context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                                   core ? coreAttributes : nullptr);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            fprintf(stderr, "Cannot create a surfaceless GL context\n");
+            return false;
+        }
+
+        // Colour and depth attachments of the offscreen framebuffer
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenRenderbuffers(2, renderbuffers);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "Offscreen framebuffer is incomplete\n");
+            return false;
+        }
+        return true;
+    }
+
+    ~OffscreenContext() {
+        if (framebuffer) {
+            glDeleteRenderbuffers(2, renderbuffers);
+            glDeleteFramebuffers(1, &framebuffer);
+        }
+        if (display != EGL_NO_DISPLAY) {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+            eglTerminate(display);
+        }
+    }
+};
+
+// rows are top to bottom, RGB
+bool writePng(const string& path, const vector<uint8_t>& rgb, int width, int height) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    if (!info || setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        fclose(file);
+        return false;
+    }
+    png_init_io(png, file);
+    png_set_compression_level(png, 1); // frames are many and short-lived; favour speed
+    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    for (int y = 0; y < height; y++) {
+        png_write_row(png, (png_const_bytep)&rgb[(size_t)y * width * 3]);
+    }
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
+    return fclose(file) == 0;
+}
+
+bool writePpm(const string& path, const vector<uint8_t>& rgb, int width, int height) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    bool ok = fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool readFile(const char* path, string& text) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    char buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, count);
+    }
+    fclose(file);
+    return true;
+}
+
+} // namespace
+
+int runHeadlessRender(int argc, char** argv) {
+    RenderOptions options;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--moves") == 0 && i + 1 < argc) {
+            options.moves += string(" ") + argv[++i];
+        } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            if (!readFile(argv[++i], options.moves)) {
+                fprintf(stderr, "Cannot open %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            options.outDir = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            options.format = argv[++i];
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            options.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            options.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames-per-turn") == 0 && i + 1 < argc) {
+            options.framesPerTurn = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            options.size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--core") == 0) {
+            options.core = true;
+        } else if (strcmp(argv[i], "--notation") == 0 && i + 1 < argc) {
+            options.standard = strcmp(argv[++i], "standard") == 0;
+            if (!options.standard && strcmp(argv[i], "keyboard") != 0) {
+                fprintf(stderr, "Unknown notation %s (keyboard or standard)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--wall") == 0 && i + 1 < argc) {
+            options.wall = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.wallFrames = atoi(argv[++i]);
+        }
+    }
+    if (options.format != "png" && options.format != "ppm" && options.format != "none") {
+        fprintf(stderr, "Unknown format %s (png, ppm or none)\n", options.format.c_str());
+        return 1;
+    }
+    if (options.width <= 0 || options.height <= 0 || options.framesPerTurn <= 0 ||
+        options.size < NxNCubeState::MIN_SIZE || options.size > NxNCubeState::MAX_SIZE) {
+        fprintf(stderr, "Bad frame size, frames per turn or cube size\n");
+        return 1;
+    }
+    if (options.wall > 0 && (!options.core || options.size != 3 || options.wallFrames <= 0)) {
+        fprintf(stderr, "--wall needs --core, a 3x3 cube and a positive --frames\n");
+        return 1;
+    }
+
+    // Parse the whole script up front so a typo fails before any rendering
+    vector<int> moves;
+    if (options.standard) {
+        Algorithm algorithm;
+        int column = 0;
+        if (!algorithm.compile(options.moves.data(), options.moves.size(), &column)) {
+            fprintf(stderr, "Bad notation at column %d of the script\n", column);
+            return 1;
+        }
+        moves.assign(algorithm.getMoves().begin(), algorithm.getMoves().end());
+    } else {
+        const char* text = options.moves.c_str();
+        const char* end = text + options.moves.size();
+        for (;;) {
+            int move = CubeState::parseMove(text, end);
+            if (move < 0) break;
+            moves.push_back(move);
+        }
+        while (text < end && isspace((unsigned char)*text)) text++;
+        if (text != end) {
+            fprintf(stderr, "Bad move at column %d of the script\n", (int)(text - options.moves.c_str()));
+            return 1;
+        }
+    }
+
+    if (options.format != "none" && mkdir(options.outDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s\n", options.outDir.c_str());
+        return 1;
+    }
+
+    OffscreenContext offscreen;
+    if (!offscreen.create(options.width, options.height, options.core)) {
+        return 1;
+    }
+    if (options.core) {
+        shaderPipeline = new ShaderPipeline();
+    }
+
+    rubiksCube = new RubiksCube(options.size);
+    camera = new Camera();
+    camera->fitToSize(options.size * 1.1f);
+    initGL();
+    reshape(options.width, options.height);
+
+    // Wall: the states of the first depth with enough of them, the camera
+    // orbiting once instead of any turns playing
+    if (options.wall > 0 && !shaderPipeline) {
+        fprintf(stderr, "--wall needs the core-profile shaders; drawing the cube instead\n");
+    } else if (options.wall > 0) {
+        vector<CubeState> states;
+        for (int depth = 0; depth <= 20 && states.size() < options.wall; depth++) {
+            states = CubeWall::statesAtDepth(CubeState(), depth, options.wall);
+        }
+        cubeWall = new CubeWall();
+        cubeWall->setStates(states);
+        cubeWall->fitCamera(*camera);
+        moves.clear();
+    }
+
+    vector<uint8_t> pixels((size_t)options.width * options.height * 4);
+    vector<uint8_t> rgb((size_t)options.width * options.height * 3);
+    double renderSeconds = 0.0;
+    size_t frames = 0;
+    bool ok = true;
+    auto startTime = chrono::steady_clock::now();
+
+    // One still frame of the start position, then framesPerTurn frames per move
+    // with the animation angle stepped evenly (independent of wall time)
+    size_t totalFrames = cubeWall ? options.wallFrames : 1 + moves.size() * options.framesPerTurn;
+    size_t visibleCubes = 0;
+    for (size_t index = 0; index < totalFrames && ok; index++) {
+        if (cubeWall && index > 0) {
+            camera->orbit(360.0f / options.wallFrames, 0.0f);
+        } else if (index > 0) {
+            size_t moveIndex = (index - 1) / options.framesPerTurn;
+            int step = (int)((index - 1) % options.framesPerTurn) + 1;
+            int move = moves[moveIndex];
+            int axis = CubeState::moveAxis(move);
+            int turn = CubeState::moveTurn(move);
+
+            currentAnimation.active = true;
+            currentAnimation.axis = axis;
+            currentAnimation.origin = rubiksCube->moveOrigin(move);
+            currentAnimation.layer = rubiksCube->layerIndex(currentAnimation.origin, axis);
+            currentAnimation.turn = turn;
+            currentAnimation.clockwise = turn != 2;
+            currentAnimation.targetAngle = turn == 1 ? 180.0f : 90.0f;
+            currentAnimation.currentAngle = currentAnimation.targetAngle * step / options.framesPerTurn;
+            if (step == options.framesPerTurn) {
+                // Last frame of a turn shows the committed state
+                currentAnimation.active = false;
+                rubiksCube->turnLayer(axis, currentAnimation.layer, turn);
+            }
+        }
+
+        auto renderStart = chrono::steady_clock::now();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (shaderPipeline) {
+            shaderPipeline->beginFrame(*camera);
+        } else {
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+            camera->apply();
+        }
+        if (cubeWall) {
+            cubeWall->draw(*camera);
+            visibleCubes += cubeWall->visibleCount();
+        } else {
+            rubiksCube->draw();
+        }
+        glReadPixels(0, 0, options.width, options.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        renderSeconds += chrono::duration<double>(chrono::steady_clock::now() - renderStart).count();
+        frames++;
+
+        if (options.format == "none") continue;
+
+        // GL rows are bottom to top
+        for (int y = 0; y < options.height; y++) {
+            const uint8_t* src = &pixels[(size_t)(options.height - 1 - y) * options.width * 4];
+            uint8_t* dst = &rgb[(size_t)y * options.width * 3];
+            for (int x = 0; x < options.width; x++) {
+                dst[x * 3] = src[x * 4];
+                dst[x * 3 + 1] = src[x * 4 + 1];
+                dst[x * 3 + 2] = src[x * 4 + 2];
+            }
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "/frame_%06zu.%s", index, options.format.c_str());
+        string path = options.outDir + name;
+        ok = options.format == "png" ? writePng(path, rgb, options.width, options.height)
+                                     : writePpm(path, rgb, options.width, options.height);
+        if (!ok) {
+            fprintf(stderr, "Cannot write %s\n", path.c_str());
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    fprintf(stderr, "Rendered %zu frames (%dx%d, %zu moves) in %.3f s: %.1f frames/s, %.1f frames/s without writing\n",
+            frames, options.width, options.height, moves.size(), seconds,
+            seconds > 0 ? frames / seconds : 0.0, renderSeconds > 0 ? frames / renderSeconds : 0.0);
+    if (cubeWall) {
+        fprintf(stderr, "Wall of %zu cubes, %.0f drawn per frame on average\n", cubeWall->size(),
+                frames > 0 ? (double)visibleCubes / frames : 0.0);
+    }
+
+    delete cubeWall;
+    cubeWall = nullptr;
+    delete rubiksCube;
+    rubiksCube = nullptr;
+    delete camera;
+    camera = nullptr;
+    delete shaderPipeline;
+    shaderPipeline = nullptr;
+    return ok ? 0 : 1;
+}
+
+namespace {
+
+struct BenchOptions {
+    int width;
+    int height;
+    int frames;
+    bool core;
+    vector<int> largeSizes;
+
+    BenchOptions() : width(800), height(600), frames(300), core(false) {
+        largeSizes.push_back(10);
+        largeSizes.push_back(30);
+    }
+};
+
+struct BenchScenario {
+    string name;
+    int size;
+    bool orbit;   // camera follows the fixed orbit and zoom path
+    bool turns;   // the move script plays without pause
+};
+
+struct BenchResult {
+    BenchScenario scenario;
+    int frames;
+    double seconds;
+    vector<double> frameMs;  // sorted
+    unsigned long long drawCalls;
+    unsigned long long vertices;
+    int turns;
+};
+
+const int WARMUP_FRAMES = 30;     // not timed: first uploads, shader compiles
+const int ORBIT_FRAMES = 240;     // frames for one full turn of the camera
+const double ANIMATION_STEP = 1.0 / 60.0;  // animation seconds per frame
+
+// Every layer in turn, alternating direction; 4 is coprime with the 9
+// layers so the script visits all of them before repeating
+int scriptMove(int index) {
+    int layer = (index * 4) % CubeState::LAYER_COUNT;
+    return layer * 3 + (index % 2 ? 2 : 0);
+}
+
+double percentileOf(const vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0.0;
+    return sorted[(size_t)(fraction * (sorted.size() - 1) + 0.5)];
+}
+
+// Frames are drawn back to back, each finished with glFinish so the time
+// includes the (software) rasteriser's work, not just command submission.
+// Turns play on an input replay's virtual clock (with no events), a fixed
+// step per frame, so every run draws the same angles however fast it goes.
+BenchResult runScenario(const BenchScenario& scenario, const BenchOptions& options) {
+    rubiksCube = new RubiksCube(scenario.size);
+    camera = new Camera();
+    camera->fitToSize(scenario.size * 1.1f);
+    reshape(options.width, options.height);
+    InputLog noInput;
+    InputReplay virtualClock(noInput, ANIMATION_STEP, 0.0);
+    inputReplay = &virtualClock;
+
+    BenchResult result;
+    result.scenario = scenario;
+    result.frames = options.frames;
+    result.seconds = 0.0;
+    result.drawCalls = 0;
+    result.vertices = 0;
+    result.turns = 0;
+
+    int scriptIndex = 0;
+    for (int frame = -WARMUP_FRAMES; frame < options.frames; frame++) {
+        if (frame == 0) {
+            result.drawCalls = frameStats->getTotalDrawCalls();
+            result.vertices = frameStats->getTotalVertices();
+        }
+        auto frameStart = chrono::steady_clock::now();
+
+        if (scenario.orbit) {
+            // Round the cube with a slow nod and a slow breathing zoom
+            int step = frame + WARMUP_FRAMES;
+            camera->orbit(360.0f / ORBIT_FRAMES, (step / 60) % 2 ? -0.5f : 0.5f);
+            camera->zoom((step / 90) % 2 ? -0.02f * scenario.size : 0.02f * scenario.size);
+        }
+        virtualClock.advance();
+        if (scenario.turns) {
+            if (!isAnimating()) {
+                int move = scriptMove(scriptIndex++);
+                startLayerAnimation(rubiksCube->moveOrigin(move), CubeState::moveAxis(move),
+                                    CubeState::moveTurn(move) == 0);
+                if (frame >= 0) result.turns++;
+            }
+            updateLayerAnimation();
+        }
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (shaderPipeline) {
+            shaderPipeline->beginFrame(*camera);
+        } else {
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+            camera->apply();
+        }
+        rubiksCube->draw();
+        glFinish();
+
+        if (frame >= 0) {
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - frameStart).count();
+            result.frameMs.push_back(ms);
+            result.seconds += ms / 1000.0;
+        }
+    }
+    result.drawCalls = frameStats->getTotalDrawCalls() - result.drawCalls;
+    result.vertices = frameStats->getTotalVertices() - result.vertices;
+    sort(result.frameMs.begin(), result.frameMs.end());
+
+    // Drops the queued turn and the one playing along with the cube
+    resetCube();
+    inputReplay = nullptr;
+    delete rubiksCube;
+    rubiksCube = nullptr;
+    delete camera;
+    camera = nullptr;
+    return result;
+}
+
+void printBenchResult(const BenchResult& r, bool last) {
+    double seconds = r.seconds > 0.0 ? r.seconds : 1e-12;
+    double frames = r.frames > 0 ? r.frames : 1;
+    printf("    {\"name\": \"%s\", \"cube_size\": %d, \"frames\": %d, \"seconds\": %.6f, "
+           "\"frames_per_sec\": %.1f, \"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, "
+           "\"p99\": %.4f, \"max\": %.4f}, \"draw_calls_per_frame\": %.2f, \"vertices_per_frame\": %.1f, "
+           "\"turns\": %d}%s\n",
+           r.scenario.name.c_str(), r.scenario.size, r.frames, r.seconds, r.frames / seconds,
+           r.seconds * 1000.0 / frames, percentileOf(r.frameMs, 0.5), percentileOf(r.frameMs, 0.9),
+           percentileOf(r.frameMs, 0.99), r.frameMs.empty() ? 0.0 : r.frameMs.back(), r.drawCalls / frames,
+           r.vertices / frames, r.turns, last ? "" : ",");
+}
+
+// JSON has no escapes worth handling in a GL string except quotes and backslashes
+string jsonText(const char* text) {
+    string escaped;
+    for (const char* c = text ? text : ""; *c; c++) {
+        if (*c == '"' || *c == '\\') escaped += '\\';
+        escaped += *c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+int runRenderBenchmark(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            options.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            options.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--core") == 0) {
+            options.core = true;
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            options.largeSizes.clear();
+            for (const char* text = argv[++i]; *text;) {
+                char* end;
+                long size = strtol(text, &end, 10);
+                if (end == text) break;
+                options.largeSizes.push_back((int)size);
+                text = *end == ',' ? end + 1 : end;
+            }
+        }
+    }
+    if (options.width <= 0 || options.height <= 0 || options.frames <= 0) {
+        fprintf(stderr, "Bad frame size or frame count\n");
+        return 1;
+    }
+    for (size_t i = 0; i < options.largeSizes.size(); i++) {
+        if (options.largeSizes[i] < NxNCubeState::MIN_SIZE || options.largeSizes[i] > NxNCubeState::MAX_SIZE) {
+            fprintf(stderr, "Cube size %d is out of range\n", options.largeSizes[i]);
+            return 1;
+        }
+    }
+
+    OffscreenContext offscreen;
+    if (!offscreen.create(options.width, options.height, options.core)) {
+        return 1;
+    }
+    if (options.core) {
+        shaderPipeline = new ShaderPipeline();
+    }
+    initGL();
+    bool ownStats = !frameStats;
+    if (ownStats) frameStats = new FrameStats();
+
+    vector<BenchScenario> scenarios;
+    BenchScenario scenario;
+    scenario.size = 3;
+    scenario.name = "static";
+    scenario.orbit = false;
+    scenario.turns = false;
+    scenarios.push_back(scenario);
+    scenario.name = "orbit";
+    scenario.orbit = true;
+    scenarios.push_back(scenario);
+    scenario.name = "animation";
+    scenario.turns = true;
+    scenarios.push_back(scenario);
+    for (size_t i = 0; i < options.largeSizes.size(); i++) {
+        scenario.size = options.largeSizes[i];
+        scenario.name = "animation_" + to_string(scenario.size);
+        scenarios.push_back(scenario);
+    }
+
+    vector<BenchResult> results;
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        fprintf(stderr, "%s (%dx%d cube)...\n", scenarios[i].name.c_str(), scenarios[i].size, scenarios[i].size);
+        results.push_back(runScenario(scenarios[i], options));
+    }
+
+    printf("{\n");
+    printf("  \"renderer\": \"%s\",\n", jsonText((const char*)glGetString(GL_RENDERER)).c_str());
+    printf("  \"gl_version\": \"%s\",\n", jsonText((const char*)glGetString(GL_VERSION)).c_str());
+    printf("  \"pipeline\": \"%s\",\n", shaderPipeline ? "core" : "fixed");
+    printf("  \"width\": %d,\n", options.width);
+    printf("  \"height\": %d,\n", options.height);
+    printf("  \"turn_seconds\": %.3f,\n", turnDuration);
+    printf("  \"scenarios\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        printBenchResult(results[i], i + 1 == results.size());
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+    if (ownStats) {
+        delete frameStats;
+        frameStats = nullptr;
+    }
+    delete shaderPipeline;
+    shaderPipeline = nullptr;
+    return 0;
+}
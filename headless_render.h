@@ -0,0 +1,30 @@
+#ifndef HEADLESS_RENDER_H
+#define HEADLESS_RENDER_H
+
+// Headless render mode: draws the cube with the normal Camera and RubiksCube
+// code into an offscreen framebuffer of a surfaceless EGL context (Mesa
+// llvmpipe works, no display or GPU needed) and writes one image per frame
+// while a scripted move sequence plays. Frames/sec goes to stderr. --core
+// renders through a GL 3.3 core context and the ShaderPipeline instead.
+// --notation standard reads the moves in Singmaster notation (see Algorithm).
+// --wall N (with --core, 3x3 only) draws a CubeWall of at least N states
+// instead, the camera orbiting it once over --frames F frames.
+//
+// Usage: rubiks_cube --render [--moves "U X' F2"] [--script file] [--out dir]
+//                    [--format png|ppm|none] [--width W] [--height H]
+//                    [--frames-per-turn K] [--size N] [--core]
+//                    [--notation keyboard|standard] [--wall N] [--frames F]
+int runHeadlessRender(int argc, char** argv);
+
+// Rendering benchmark on the same offscreen context: fixed scenarios (a
+// still 3x3, the camera orbiting it via Camera::orbit and Camera::zoom, the
+// move script playing through startLayerAnimation as well, then the same on
+// each larger size) drawn back to back with no frame cap, each frame ended by
+// glFinish. Prints frames/sec, frame-time percentiles and draw calls per
+// frame of every scenario as JSON on stdout.
+//
+// Usage: rubiks_cube --render-bench [--frames 300] [--width W] [--height H]
+//                    [--sizes 10,30] [--core]
+int runRenderBenchmark(int argc, char** argv);
+
+#endif
@@ -1,7 +1,19 @@
 #include "input_handler.h"
+#include <GL/freeglut.h>
+#include "frame_stats.h"
+#include "move_queue.h"
+#include "move_journal.h"
+#include "algorithm.h"
+#include "cube_wall.h"
+#include "shader_pipeline.h"
+#include "async_solver.h"
+#include "input_log.h"
+#include "latency_stats.h"
 #include <iostream>
 #include <cmath>
 #include <cctype>
+#include <chrono>
+#include <vector>
 
 using namespace std;
 
@@ -11,15 +23,118 @@ int lastMouseX = 0, lastMouseY = 0;
 bool isRotating = false;
 float rotationSpeed = 1.0f;
 LayerAnimation currentAnimation;
+double turnDuration = 0.5;    // seconds per quarter turn
+MoveQueue moveQueue;          // Turns waiting to be animated
+size_t fastForwardThreshold = 64; // Queued turns beyond which the backlog is applied without animation
+const char* journalPath = nullptr;  // Session journal file, saved on exit
+
+// Drag-to-turn: a left press on a sticker turns its layer instead of orbiting
+static bool stickerDrag = false;     // the press hit a sticker
+static bool dragTurned = false;      // this drag already started its turn
+static StickerHit dragHit;
+static int dragStartX = 0, dragStartY = 0;
+static const int DRAG_THRESHOLD = 8; // pixels before the drag direction counts
+
+// Algorithm entry: '/' starts typing standard notation, Enter plays it
+static bool algorithmEntry = false;
+static string algorithmText;
+static AlgorithmCache algorithmCache;
+
+// Background solve: the moves arrive one by one and are queued together once
+// the whole solution is in, so a cancel never leaves half of one playing
+static vector<int> solutionMoves;
+static double lastProgressReport = 0.0;
+static const double PROGRESS_INTERVAL = 0.5;  // seconds between progress lines
+
+// Largest cube wall the W key builds
+static const size_t MAX_WALL_CUBES = 10000;
+
+// Keys while an algorithm is being typed; the line is echoed on the console
+static void algorithmKey(unsigned char key) {
+    if (key == '\r' || key == '\n') {
+        algorithmEntry = false;
+        cout << endl;
+        int column = 0;
+        const Algorithm* algorithm = algorithmCache.get(algorithmText, &column);
+        if (!algorithm) {
+            cout << "Bad notation at column " << column << endl;
+        } else if (rubiksCube) {
+            playAlgorithm(*algorithm);
+        }
+        return;
+    }
+    if (key == 27) {
+        algorithmEntry = false;
+        cout << " (cancelled)" << endl;
+        return;
+    }
+    if (key == 8 || key == 127) {
+        if (!algorithmText.empty()) algorithmText.erase(algorithmText.size() - 1);
+    } else if (isprint(key)) {
+        algorithmText += (char)key;
+    }
+    cout << "\r\033[KAlgorithm: " << algorithmText << flush;
+}
+
+// Turn the layer a drag from the picked sticker in window direction (dx, dy)
+// moves: compare the drag with the on-screen direction of the two axes along
+// the face, then the turn axis is perpendicular to both the face and the drag.
+static void dragTurn(const StickerHit& hit, float dx, float dy) {
+    const int* normal = CubeState::faceNormal(hit.face);
+    int normalAxis = normal[0] != 0 ? 0 : (normal[1] != 0 ? 1 : 2);
+    float startX, startY;
+    if (!camera->project(hit.point, startX, startY)) return;
+
+    int dragAxis = -1;
+    float dragSign = 0.0f;
+    float best = 0.0f;
+    for (int a = 0; a < 3; a++) {
+        if (a == normalAxis) continue;
+        float step[3] = {0.0f, 0.0f, 0.0f};
+        step[a] = 0.5f;
+        point3f along(hit.point.x + step[0], hit.point.y + step[1], hit.point.z + step[2]);
+        float endX, endY;
+        if (!camera->project(along, endX, endY)) continue;
+        float sx = endX - startX;
+        float sy = endY - startY;
+        float length = sqrt(sx * sx + sy * sy);
+        if (length < 1e-6f) continue;
+        float score = (dx * sx + dy * sy) / length;
+        if (fabs(score) > best) {
+            best = fabs(score);
+            dragAxis = a;
+            dragSign = score > 0.0f ? 1.0f : -1.0f;
+        }
+    }
+    if (dragAxis < 0) return;
+
+    // Rotation taking the face normal towards the drag: normal x drag
+    int axis = 3 - normalAxis - dragAxis;
+    int drag[3] = {0, 0, 0};
+    drag[dragAxis] = (int)dragSign;
+    int rotation = normal[(axis + 1) % 3] * drag[(axis + 2) % 3] - normal[(axis + 2) % 3] * drag[(axis + 1) % 3];
+    bool clockwise = rotation == CubeState::clockwiseSign(axis);
+    startLayerAnimation(rubiksCube->layerOrigin(axis, hit.cubie[axis]), axis, clockwise);
+}
 
 void handleMouse(int button, int state, int x, int y) {
+    stampInput(LatencyStats::MOUSE);
     if (button == GLUT_LEFT_BUTTON) {
         if (state == GLUT_DOWN) {
-            mouseDown = true;
+            point3f origin, direction;
+            // The wall's cubes are only looked at; every drag orbits
+            bool pickable = camera && rubiksCube && !cubeWall;
+            if (pickable) camera->pickRay(x, y, origin, direction);
+            stickerDrag = pickable && rubiksCube->pickSticker(origin, direction, dragHit);
+            dragTurned = false;
+            dragStartX = x;
+            dragStartY = y;
+            mouseDown = !stickerDrag;
             lastMouseX = x;
             lastMouseY = y;
         } else {
             mouseDown = false;
+            stickerDrag = false;
         }
     } else if (button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN) {
         // Right click to reset camera
@@ -28,20 +143,32 @@ void handleMouse(int button, int state, int x, int y) {
     }
     
     // Mouse wheel for zooming
+    // (the wall is hundreds of units across, so there a step is a tenth of the distance)
+    float zoomStep = cubeWall && camera ? camera->getDistance() * 0.1f : 0.5f;
     if (button == 3 && state == GLUT_DOWN) { // Wheel up
         if (camera) {
-            camera->zoom(-0.5f);
+            camera->zoom(-zoomStep);
             glutPostRedisplay();
         }
     } else if (button == 4 && state == GLUT_DOWN) { // Wheel down
         if (camera) {
-            camera->zoom(0.5f);
+            camera->zoom(zoomStep);
             glutPostRedisplay();
         }
     }
 }
 
 void handleMouseMotion(int x, int y) {
+    stampInput(LatencyStats::MOTION);
+    if (stickerDrag && !dragTurned) {
+        float dx = (float)(x - dragStartX);
+        float dy = (float)(y - dragStartY);
+        if (dx * dx + dy * dy >= DRAG_THRESHOLD * DRAG_THRESHOLD) {
+            dragTurned = true;
+            dragTurn(dragHit, dx, dy);
+        }
+        return;
+    }
     if (mouseDown && camera) {
         float deltaX = (x - lastMouseX);
         float deltaY = (y - lastMouseY);
@@ -57,9 +184,14 @@ void handleMouseMotion(int x, int y) {
     }
 }
 
-void handleKeyboard(unsigned char key, int x, int y) {
+void handleKeyboard(unsigned char key, int x, int y, int modifiers) {
+    stampInput(LatencyStats::KEYBOARD);
+    if (algorithmEntry) {
+        algorithmKey(key);
+        return;
+    }
+
     // Check if Shift is pressed for counter-clockwise rotation
-    int modifiers = glutGetModifiers();
     bool shiftPressed = (modifiers & GLUT_ACTIVE_SHIFT) != 0;
     bool clockwise = !shiftPressed; // Regular key = clockwise, Shift+key = counter-clockwise
     
@@ -69,6 +201,11 @@ void handleKeyboard(unsigned char key, int x, int y) {
     switch (lowerKey) {
         case 27: // Escape key
             cout << "Exiting Rubik's Cube..." << endl;
+            saveJournal();
+            saveRecording();
+            if (latencyStats) latencyStats->printReport();
+            delete asyncSolver; // stops a running solve before the tables go away
+            delete frameStats; // flushes the stats CSV
             delete rubiksCube;
             exit(0);
             break;
@@ -83,53 +220,111 @@ void handleKeyboard(unsigned char key, int x, int y) {
             printControls();
             break;
             
+        case '/': // Type an algorithm in standard notation
+            algorithmEntry = true;
+            algorithmText.clear();
+            cout << "Algorithm: " << flush;
+            break;
+            
+        case 'p': // Frame stats overlay
+            if (frameStats) {
+                frameStats->toggleOverlay();
+                glutPostRedisplay();
+            }
+            break;
+            
+        case 'i': // Input latency histograms so far
+            if (latencyStats) {
+                latencyStats->printReport();
+            } else {
+                cout << "Start with --latency to measure input latency" << endl;
+            }
+            break;
+            
+        case 'o': // Solve with the optimal solver; again to cancel
+            if (rubiksCube && (isSolving() || !isAnimating())) {
+                solveCube(true);
+            }
+            break;
+            
+        case 'k': // Solve with the two-phase solver; again to cancel
+            if (rubiksCube && (isSolving() || !isAnimating())) {
+                solveCube(false);
+            }
+            break;
+            
+        case 'z': // Undo; Shift+Z goes back to the start
+            if (rubiksCube && moveJournal) {
+                if (shiftPressed) {
+                    jumpTo(0);
+                } else {
+                    undoTurn();
+                }
+            }
+            break;
+            
+        case 'y': // Redo; Shift+Y goes to the latest turn
+            if (rubiksCube && moveJournal) {
+                if (shiftPressed) {
+                    jumpTo(moveJournal->size());
+                } else {
+                    redoTurn();
+                }
+            }
+            break;
+            
+        case 'w': // Wall of the states two turns away; Shift+W three turns
+            toggleCubeWall(shiftPressed ? 3 : 2);
+            glutPostRedisplay();
+            break;
+
         // Layer rotations - Y-axis (horizontal layers)
         case 'u': // Up/Top layer
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->topOrigin, 1, clockwise);
             }
             break;
             
         case 'm': // Middle horizontal layer
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->middleOrigin, 1, clockwise);
             }
             break;
             
         case 'd': // Down/Bottom layer
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->bottomOrigin, 1, clockwise);
             }
             break;
             
         // Layer rotations - X-axis (vertical layers)
         case 'l': // Left layer
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->leftOrigin, 0, clockwise);
             }
             break;
             
         case 'c': // Center vertical layer
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->centerOrigin, 0, clockwise);
             }
             break;
             
         case 'x': // Right layer (using 'x' since 'r' is reset)
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->rightOrigin, 0, clockwise);
             }
             break;
             
         // Layer rotations - Z-axis (front/back layers)
         case 'f': // Front layer
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->frontOrigin, 2, clockwise);
             }
             break;
             
         case 'b': // Back layer
-            if (rubiksCube && !currentAnimation.active) {
+            if (rubiksCube) {
                 startLayerAnimation(rubiksCube->backOrigin, 2, clockwise);
             }
             break;
@@ -139,6 +334,11 @@ void handleKeyboard(unsigned char key, int x, int y) {
 
 // Cube manipulation functions
 void resetCube() {
+    cancelSolve();
+    moveQueue.clear();
+    if (moveJournal) {
+        moveJournal->clear();
+    }
     if (camera) {
         camera->reset();
     }
@@ -147,12 +347,132 @@ void resetCube() {
     }
 }
 
+void toggleCubeWall(int depth) {
+    if (cubeWall) {
+        delete cubeWall;
+        cubeWall = nullptr;
+        if (camera && rubiksCube) camera->fitToSize(rubiksCube->getSize() * 1.1f);
+        return;
+    }
+    if (!shaderPipeline) {
+        cout << "The cube wall needs the core profile (--core)" << endl;
+        return;
+    }
+    if (!rubiksCube || rubiksCube->getSize() != 3) {
+        cout << "The cube wall shows 3x3 states only" << endl;
+        return;
+    }
+
+    cubeWall = new CubeWall();
+    cubeWall->setStates(CubeWall::statesAtDepth(rubiksCube->getState(), depth, MAX_WALL_CUBES));
+    if (camera) cubeWall->fitCamera(*camera);
+    cout << "Cube wall: " << cubeWall->size() << " states " << depth << " turns away (W hides it)" << endl;
+}
+
+// Snapshot the cube and solve it on the worker thread; the solution is
+// picked up by updateLayerAnimation. A second O or K cancels.
+void solveCube(bool optimal) {
+    if (rubiksCube->getSize() != 3) {
+        cout << "The solvers only handle the 3x3 cube" << endl;
+        return;
+    }
+    if (isSolving()) {
+        cancelSolve();
+        return;
+    }
+
+    if (!asyncSolver) {
+        asyncSolver = new AsyncSolver();
+    }
+    if (!asyncSolver->start(rubiksCube->getState(), optimal ? AsyncSolver::OPTIMAL : AsyncSolver::TWO_PHASE)) {
+        cout << "The last solve is still stopping, try again in a moment" << endl;
+        return;
+    }
+    solutionMoves.clear();
+    lastProgressReport = animationClock();
+    cout << (optimal ? "Solving optimally" : "Solving (two-phase)") << "; turn a layer or press "
+         << (optimal ? 'O' : 'K') << " again to cancel" << endl;
+    glutPostRedisplay();
+}
+
+void cancelSolve() {
+    if (isSolving()) {
+        asyncSolver->cancel();
+        solutionMoves.clear();
+        cout << "\r\033[KSolve cancelled" << endl;
+    }
+}
+
+bool isSolving() {
+    return asyncSolver && asyncSolver->isActive();
+}
+
+// Collect what the solver sent since the last frame; report progress while
+// it searches and play the solution once it is complete
+static void drainSolver() {
+    if (!isSolving()) return;
+
+    // A replay takes the whole answer on the frame after the request, however
+    // long the search runs, so the moves start on the same frame every time
+    if (inputReplay) asyncSolver->wait();
+
+    int event;
+    while (asyncSolver->poll(event)) {
+        if (event >= 0) {
+            solutionMoves.push_back(event);
+            continue;
+        }
+
+        const SolverProgress& progress = asyncSolver->progress();
+        double seconds = asyncSolver->elapsed();
+        if (event == AsyncSolver::FAILED) {
+            cout << "\r\033[KNo solution found" << endl;
+            return;
+        }
+        cout << "\r\033[K" << (asyncSolver->getMethod() == AsyncSolver::OPTIMAL ? "Optimal" : "Two-phase")
+             << " solution (" << solutionMoves.size() << " moves, " << progress.nodes.load() << " nodes, "
+             << seconds << " s):";
+        for (size_t i = 0; i < solutionMoves.size(); i++) {
+            cout << " " << CubeState::moveName(solutionMoves[i]);
+            queueMove(solutionMoves[i]);
+        }
+        cout << endl;
+        solutionMoves.clear();
+        return;
+    }
+
+    double now = animationClock();
+    if (now - lastProgressReport >= PROGRESS_INTERVAL) {
+        lastProgressReport = now;
+        const SolverProgress& progress = asyncSolver->progress();
+        double seconds = asyncSolver->elapsed();
+        unsigned long long nodes = progress.nodes.load(std::memory_order_relaxed);
+        int depth = progress.depth.load(std::memory_order_relaxed);
+        const char* building = progress.building.load(std::memory_order_relaxed);
+        if (building) {
+            cout << "\r\033[KSolving: building " << building << " table (one time), depth " << depth << ", "
+                 << nodes << " states (" << (int)seconds << " s)" << flush;
+        } else if (depth == 0 && nodes == 0) {
+            cout << "\r\033[KSolving: loading tables (" << (int)seconds << " s)" << flush;
+        } else {
+            cout << "\r\033[KSolving: depth " << depth << ", " << nodes << " nodes, "
+                 << (seconds > 0.0 ? nodes / seconds / 1e6 : 0.0) << " M nodes/s" << flush;
+        }
+    }
+}
+
 void printControls() {
     cout << "\n=== Rubik's Cube Controls ===" << endl;
     cout << "Mouse:" << endl;
-    cout << "  Left click + drag: Orbit camera around cube" << endl;
+    cout << "  Left drag on a sticker: Turn its layer in the drag direction" << endl;
+    cout << "  Left drag off the cube: Orbit camera around cube" << endl;
     cout << "  Mouse wheel: Zoom in/out" << endl;
     cout << "  Right click: Reset camera and cube" << endl;
+    cout << "  P: Toggle frame stats overlay" << endl;
+    cout << "  I: Print input latency histograms (with --latency)" << endl;
+    cout << "  Z / Y: Undo / redo a turn (Shift: back to the start / to the latest)" << endl;
+    cout << "  /: Type an algorithm in standard notation, Enter plays it" << endl;
+    cout << "  W: Show/hide every state two turns away (Shift: three), needs --core" << endl;
     cout << "\nLayer Rotations:" << endl;
     cout << "  Key alone = Clockwise rotation" << endl;
     cout << "  Shift + Key = Counter-clockwise rotation" << endl;
@@ -167,42 +487,185 @@ void printControls() {
     cout << "\nDepth Layers (Z-axis):" << endl;
     cout << "  F: Front layer" << endl;
     cout << "  B: Back layer" << endl;
+    cout << "\nSolver:" << endl;
+    cout << "  O: Solve optimally and play the solution (again to cancel)" << endl;
+    cout << "  K: Solve quickly (two-phase) and play the solution (again to cancel)" << endl;
+    cout << "  The solvers run in the background; turning a layer cancels them" << endl;
     cout << "==========================================\n" << endl;
 }
 
 // Animation functions
-void updateLayerAnimation() {
+
+// Monotonic time in seconds; animations are timed with it, not by frame count.
+// A replay runs on its own virtual clock instead.
+double animationClock() {
+    if (inputReplay) return inputReplay->now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Start animating a turn taken from the queue. Turns play faster while a
+// backlog waits, so long scripted or solver sequences catch up.
+static void beginTurn(const MoveQueue::Turn& turn) {
+    currentAnimation.active = true;
+    currentAnimation.origin = rubiksCube->layerOrigin(turn.axis, turn.layer);
+    currentAnimation.axis = turn.axis;
+    currentAnimation.layer = turn.layer;
+    currentAnimation.turn = turn.quarters - 1;
+    currentAnimation.clockwise = turn.quarters != 3;
+    currentAnimation.currentAngle = 0;
+    currentAnimation.targetAngle = turn.quarters == 2 ? 180 : 90;
+    currentAnimation.startTime = animationClock();
+    currentAnimation.duration = turnDuration * (turn.quarters == 2 ? 1.5 : 1.0) / (1.0 + moveQueue.size() / 4.0);
+}
+
+// Apply the turn being animated and everything queued straight to the cube
+static void fastForward() {
     if (currentAnimation.active) {
-        currentAnimation.currentAngle += currentAnimation.speed;
-        
-        if (currentAnimation.currentAngle >= currentAnimation.targetAngle) {
-            // Animation complete - apply final rotation to cube state
-            currentAnimation.currentAngle = currentAnimation.targetAngle;
-            currentAnimation.active = false;
-            
-            // Apply the rotation to the actual cube data
-            if (rubiksCube) {
-                rubiksCube->rotateLayer(currentAnimation.origin, currentAnimation.axis, currentAnimation.clockwise);
+        currentAnimation.active = false;
+        rubiksCube->turnLayer(currentAnimation.axis, currentAnimation.layer, currentAnimation.turn);
+    }
+    MoveQueue::Turn turn;
+    while (moveQueue.pop(turn)) {
+        rubiksCube->turnLayer(turn.axis, turn.layer, turn.quarters - 1);
+    }
+    glutPostRedisplay();
+}
+
+static void playTurn(int axis, int layer, int quarters) {
+    if (!moveQueue.push(axis, layer, quarters)) {
+        fastForward();
+        moveQueue.push(axis, layer, quarters);
+    }
+    // The headless benchmark queues turns too, without a GLUT window
+    if (glutGet(GLUT_INIT_STATE)) glutPostRedisplay();
+}
+
+// The journal records turns as they are queued, so it always holds the
+// state the cube is heading for and undo can act before the turn plays
+static void enqueueTurn(int axis, int layer, int quarters) {
+    if (moveJournal) {
+        moveJournal->record(axis, layer, quarters - 1);
+    }
+    playTurn(axis, layer, quarters);
+}
+
+// Animate an algorithm turn by turn. One too long to animate on the 3x3 is
+// applied as its single compiled gather (and journalled turn by turn).
+void playAlgorithm(const Algorithm& algorithm) {
+    cancelSolve();
+    const std::vector<uint8_t>& moves = algorithm.getMoves();
+    if (rubiksCube->getSize() != 3 || moves.size() <= fastForwardThreshold) {
+        for (size_t i = 0; i < moves.size(); i++) {
+            queueMove(moves[i]);
+        }
+        return;
+    }
+
+    fastForward();
+    CubeState state = rubiksCube->getState();
+    algorithm.apply(state);
+    rubiksCube->setState(state);
+    if (moveJournal) {
+        for (size_t i = 0; i < moves.size(); i++) {
+            int axis = CubeState::moveAxis(moves[i]);
+            moveJournal->record(axis, rubiksCube->layerIndex(rubiksCube->moveOrigin(moves[i]), axis),
+                                CubeState::moveTurn(moves[i]));
+        }
+    }
+    glutPostRedisplay();
+}
+
+// Undo and redo animate the one turn; they are not recorded themselves
+void undoTurn() {
+    cancelSolve();
+    MoveJournal::Turn turn;
+    if (moveJournal && moveJournal->undo(turn)) {
+        playTurn(turn.axis, turn.layer, turn.turn + 1);
+    }
+}
+
+void redoTurn() {
+    cancelSolve();
+    MoveJournal::Turn turn;
+    if (moveJournal && moveJournal->redo(turn)) {
+        playTurn(turn.axis, turn.layer, turn.turn + 1);
+    }
+}
+
+// Show the cube after the first position journal turns at once, dropping
+// whatever is still animating (the journal already holds its end state)
+void jumpTo(size_t position) {
+    cancelSolve();
+    if (!moveJournal || !moveJournal->seek(position)) return;
+    moveQueue.clear();
+    currentAnimation.active = false;
+    currentAnimation.currentAngle = 0;
+    rubiksCube->setCube(moveJournal->state());
+    glutPostRedisplay();
+}
+
+void saveJournal() {
+    if (moveJournal && journalPath && !moveJournal->save(journalPath)) {
+        cerr << "Cannot write " << journalPath << endl;
+    }
+}
+
+// Advance the animation to the current time. A slow frame can finish a turn
+// (or several queued ones); the next queued turn starts where the last one ended.
+void updateLayerAnimation() {
+    if (!rubiksCube) return;
+    drainSolver();
+    if (moveQueue.size() > fastForwardThreshold) {
+        fastForward();
+    }
+
+    double now = animationClock();
+    bool carryOver = false;
+    double carryStart = 0.0;
+
+    while (true) {
+        if (!currentAnimation.active) {
+            MoveQueue::Turn turn;
+            if (!moveQueue.pop(turn)) break;
+            beginTurn(turn);
+            if (carryOver) {
+                currentAnimation.startTime = carryStart;
             }
         }
-        
-        glutPostRedisplay();
+
+        double progress = (now - currentAnimation.startTime) / currentAnimation.duration;
+        if (progress < 1.0) {
+            currentAnimation.currentAngle = (float)(progress * currentAnimation.targetAngle);
+            break;
+        }
+
+        // Animation complete - apply final rotation to cube state
+        currentAnimation.currentAngle = currentAnimation.targetAngle;
+        currentAnimation.active = false;
+        rubiksCube->turnLayer(currentAnimation.axis, currentAnimation.layer, currentAnimation.turn);
+        carryOver = true;
+        carryStart = currentAnimation.startTime + currentAnimation.duration;
     }
 }
 
+// Queue a quarter turn of the layer at origin; it plays after the turns before
+// it. A turn by hand makes a running solve's answer stale, so it cancels it.
 void startLayerAnimation(point3f origin, int axis, bool clockwise) {
-    if (!currentAnimation.active) {
-        currentAnimation.active = true;
-        currentAnimation.origin = origin;
-        currentAnimation.axis = axis;
-        currentAnimation.clockwise = clockwise;
-        currentAnimation.currentAngle = 0;
-        currentAnimation.targetAngle = 90;
-        currentAnimation.speed = 3.0f; // degrees per frame
+    cancelSolve();
+    if (rubiksCube) {
+        enqueueTurn(axis, rubiksCube->layerIndex(origin, axis), clockwise ? 1 : 3);
     }
 }
 
-bool isAnimating() {
-    return currentAnimation.active;
+// Queue a CubeState move to be animated after the current one
+void queueMove(int move) {
+    if (rubiksCube) {
+        int axis = CubeState::moveAxis(move);
+        enqueueTurn(axis, rubiksCube->layerIndex(rubiksCube->moveOrigin(move), axis), CubeState::moveTurn(move) + 1);
+    }
 }
 
+// True while a turn is playing or waiting to play
+bool isAnimating() {
+    return currentAnimation.active || !moveQueue.empty();
+}
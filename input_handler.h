@@ -4,25 +4,42 @@
 #include <GL/glut.h>
 #include "cube.h"
 #include "camera.h"
+#include "algorithm.h"
 
 // Input state variables
 extern bool mouseDown;
 extern int lastMouseX, lastMouseY;
 
 extern LayerAnimation currentAnimation;
+extern double turnDuration;
+extern size_t fastForwardThreshold;
+extern const char* journalPath;
 
 // Input handling functions
 void handleMouse(int button, int state, int x, int y);
 void handleMouseMotion(int x, int y);
-void handleKeyboard(unsigned char key, int x, int y);
+void handleKeyboard(unsigned char key, int x, int y, int modifiers);  // GLUT_ACTIVE_* held
 
 // Cube manipulation functions
 void resetCube();
+void solveCube(bool optimal);  // in the background (asyncSolver)
+void cancelSolve();
+bool isSolving();
 void printControls();
+void toggleCubeWall(int depth);  // show the states depth turns from the current one, or hide them
+
+// Session history (moveJournal)
+void undoTurn();
+void redoTurn();
+void jumpTo(size_t position);
+void saveJournal();
 
 // Animation functions
+double animationClock();
 void updateLayerAnimation();
 void startLayerAnimation(point3f origin, int axis, bool clockwise);
+void queueMove(int move);
+void playAlgorithm(const Algorithm& algorithm);
 bool isAnimating();
 
 
@@ -0,0 +1,206 @@
+#include "input_log.h"
+#include <GL/glut.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "input_handler.h"
+#include "nxn_cube_state.h"
+#include "table_file.h"
+
+InputLog* inputRecording = nullptr;
+const char* recordingPath = nullptr;
+InputReplay* inputReplay = nullptr;
+
+namespace {
+
+const char INPUT_MAGIC[8] = {'R', 'C', 'I', 'N', 'P', 'U', 'T', 'S'};
+const uint32_t INPUT_VERSION = 1;
+
+struct InputHeader {
+    uint32_t cubeSize;
+    uint32_t reserved;
+    uint64_t turnMicroseconds;
+    uint64_t eventCount;
+};
+
+struct DiskEvent {
+    uint32_t delay;  // microseconds after the previous event
+    uint8_t type;
+    uint8_t code;
+    uint8_t state;
+    uint8_t modifiers;
+    int32_t x, y;
+};
+
+double realClock() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// splitmix64 step over the running checksum and one more word
+uint64_t mix(uint64_t checksum, uint64_t word) {
+    uint64_t z = checksum ^ (word + 0x9E3779B97F4A7C15ULL + (checksum << 6) + (checksum >> 2));
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+InputLog::InputLog() : cubeSize(3), turnDuration(0.5), startTime(0.0) {
+}
+
+void InputLog::start(int size, double duration) {
+    events.clear();
+    cubeSize = size;
+    turnDuration = duration;
+    startTime = realClock();
+}
+
+void InputLog::add(Type type, int code, int state, int modifiers, int x, int y) {
+    Event event;
+    double elapsed = realClock() - startTime;
+    event.time = elapsed > 0.0 ? (uint64_t)(elapsed * 1e6) : 0;
+    if (!events.empty() && event.time < events.back().time) event.time = events.back().time;
+    event.type = (uint8_t)type;
+    event.code = (uint8_t)code;
+    event.state = (uint8_t)state;
+    event.modifiers = (uint8_t)modifiers;
+    event.x = x;
+    event.y = y;
+    events.push_back(event);
+}
+
+bool InputLog::save(const std::string& path) const {
+    InputHeader header;
+    header.cubeSize = (uint32_t)cubeSize;
+    header.reserved = 0;
+    header.turnMicroseconds = (uint64_t)(turnDuration * 1e6 + 0.5);
+    header.eventCount = events.size();
+
+    // Gaps beyond 71 minutes are shortened to that
+    std::vector<DiskEvent> disk(events.size());
+    uint64_t previous = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        uint64_t delay = events[i].time - previous;
+        previous = events[i].time;
+        disk[i].delay = delay > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (uint32_t)delay;
+        disk[i].type = events[i].type;
+        disk[i].code = events[i].code;
+        disk[i].state = events[i].state;
+        disk[i].modifiers = events[i].modifiers;
+        disk[i].x = events[i].x;
+        disk[i].y = events[i].y;
+    }
+
+    std::vector<TableFile::Section> sections;
+    sections.push_back(TableFile::Section(&header, sizeof(header)));
+    sections.push_back(TableFile::Section(disk.data(), disk.size() * sizeof(DiskEvent)));
+    return TableFile::write(path, INPUT_MAGIC, INPUT_VERSION, sections);
+}
+
+bool InputLog::load(const std::string& path) {
+    TableFile file;
+    std::vector<size_t> sizes;
+    sizes.push_back(sizeof(InputHeader));
+    sizes.push_back(TableFile::ANY_SIZE);
+    if (!file.map(path, INPUT_MAGIC, INPUT_VERSION, sizes)) return false;
+
+    InputHeader header;
+    memcpy(&header, file.section(0), sizeof(header));
+    if (header.cubeSize < (uint32_t)NxNCubeState::MIN_SIZE || header.cubeSize > (uint32_t)NxNCubeState::MAX_SIZE ||
+        header.turnMicroseconds == 0 || file.sectionSize(1) % sizeof(DiskEvent) != 0 ||
+        header.eventCount != file.sectionSize(1) / sizeof(DiskEvent)) {
+        return false;
+    }
+
+    std::vector<Event> loaded(header.eventCount);
+    uint64_t time = 0;
+    for (size_t i = 0; i < loaded.size(); i++) {
+        DiskEvent disk;
+        memcpy(&disk, file.section(1) + i * sizeof(DiskEvent), sizeof(disk));
+        if (disk.type > RESHAPE) return false;
+        time += disk.delay;
+        loaded[i].time = time;
+        loaded[i].type = disk.type;
+        loaded[i].code = disk.code;
+        loaded[i].state = disk.state;
+        loaded[i].modifiers = disk.modifiers;
+        loaded[i].x = disk.x;
+        loaded[i].y = disk.y;
+    }
+
+    events.swap(loaded);
+    cubeSize = (int)header.cubeSize;
+    turnDuration = header.turnMicroseconds / 1e6;
+    return true;
+}
+
+InputReplay::InputReplay(const InputLog& log, double interval, double replaySpeed)
+    : events(log.getEvents()), next(0), frames(0), frameInterval(interval), speed(replaySpeed),
+      realStart(realClock()), pathChecksum(0) {
+}
+
+bool InputReplay::advance() {
+    frames++;
+    uint64_t due = (uint64_t)(now() * 1e6);
+    while (next < events.size() && events[next].time <= due) {
+        const InputLog::Event& event = events[next++];
+        switch (event.type) {
+            case InputLog::MOUSE:
+                handleMouse(event.code, event.state, event.x, event.y);
+                break;
+            case InputLog::MOTION:
+                handleMouseMotion(event.x, event.y);
+                break;
+            case InputLog::KEYBOARD:
+                handleKeyboard(event.code, event.x, event.y, event.modifiers);
+                break;
+            case InputLog::RESHAPE:
+                // The camera takes the recorded size even if the window
+                // manager will not give the window exactly that
+                glutReshapeWindow(event.x, event.y);
+                if (camera) camera->setViewport(event.x, event.y);
+                break;
+        }
+    }
+    return next < events.size();
+}
+
+void InputReplay::endFrame(uint64_t cubeHash, const Camera& camera) {
+    pathChecksum = mix(pathChecksum, cubeHash);
+    pathChecksum = mix(pathChecksum, floatBits(camera.getAzimuth()) << 32 | floatBits(camera.getElevation()));
+    pathChecksum = mix(pathChecksum, floatBits(camera.getDistance()) << 32 |
+                                         floatBits(currentAnimation.active ? currentAnimation.currentAngle : 0.0f));
+}
+
+double InputReplay::nextFrameDelay() const {
+    if (speed <= 0.0) return 0.0;
+    double due = realStart + frames * frameInterval / speed;
+    double wait = due - realClock();
+    return wait > 0.0 ? wait : 0.0;
+}
+
+void InputReplay::printSummary(uint64_t cubeHash, const Camera& camera) const {
+    double seconds = realClock() - realStart;
+    printf("Replayed %zu events in %llu frames (%.3f s virtual, %.3f s real, %.1f frames/s)\n", events.size(),
+           (unsigned long long)frames, now(), seconds, seconds > 0.0 ? frames / seconds : 0.0);
+    printf("Cube hash %016llx, camera azimuth %.3f elevation %.3f distance %.3f, path checksum %016llx\n",
+           (unsigned long long)cubeHash, camera.getAzimuth(), camera.getElevation(), camera.getDistance(),
+           (unsigned long long)pathChecksum);
+}
+
+void saveRecording() {
+    if (inputRecording && recordingPath) {
+        if (inputRecording->save(recordingPath)) {
+            printf("Saved %zu input events to %s\n", inputRecording->getEvents().size(), recordingPath);
+        } else {
+            fprintf(stderr, "Cannot write %s\n", recordingPath);
+        }
+    }
+}
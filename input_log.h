@@ -0,0 +1,98 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "camera.h"
+
+// Every input event of a window session with its time, for replaying the
+// session exactly (--record FILE, then --replay FILE).
+//
+// On disk (a TableFile) each event is 16 bytes: the microseconds since the
+// previous event, the event type, button or key, button state, modifier keys
+// and the window position (or the new size of a reshape). The header keeps
+// the cube size and turn time, which a replay must share with the recording.
+class InputLog {
+public:
+    enum Type { MOUSE, MOTION, KEYBOARD, RESHAPE };
+
+    struct Event {
+        uint64_t time;      // microseconds since the recording started
+        uint8_t type;
+        uint8_t code;       // mouse button or key
+        uint8_t state;      // GLUT_DOWN or GLUT_UP
+        uint8_t modifiers;  // GLUT_ACTIVE_* with a key
+        int32_t x, y;       // window position, or width and height
+    };
+
+    InputLog();
+
+    // Forget the events and restart the clock
+    void start(int cubeSize, double turnDuration);
+    void add(Type type, int code, int state, int modifiers, int x, int y);
+
+    const std::vector<Event>& getEvents() const { return events; }
+    int getCubeSize() const { return cubeSize; }
+    double getTurnDuration() const { return turnDuration; }
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    std::vector<Event> events;
+    int cubeSize;
+    double turnDuration;
+    double startTime;
+};
+
+// Plays an InputLog back through the input handlers under a virtual clock.
+//
+// Every frame moves the virtual clock (animationClock() while a replay runs)
+// on by exactly one frame interval and hands the events due by then to
+// handleMouse, handleMouseMotion and handleKeyboard; a reshape resizes the
+// window and sets the camera's viewport to the recorded size. The frames,
+// and so the turns, animation angles and camera at each one, are the same at
+// any speed and in any build; speed only sets how fast frames follow each
+// other in real time: 1 is the recorded pace, N is N times faster and 0
+// draws frames back to back. A checksum over the cube hash and camera of
+// every frame lets two runs be compared.
+class InputReplay {
+public:
+    InputReplay(const InputLog& log, double frameInterval, double speed);
+
+    // Virtual seconds since the replay started
+    double now() const { return frames * frameInterval; }
+
+    // Start the next frame: dispatch the events due by its time. False once
+    // every event has been dispatched.
+    bool advance();
+
+    // Fold the frame's result into the path checksum
+    void endFrame(uint64_t cubeHash, const Camera& camera);
+
+    // Real seconds until the next frame is due (0 when running flat out)
+    double nextFrameDelay() const;
+
+    void printSummary(uint64_t cubeHash, const Camera& camera) const;
+
+private:
+    std::vector<InputLog::Event> events;
+    size_t next;
+    uint64_t frames;
+    double frameInterval;
+    double speed;
+    double realStart;
+    uint64_t pathChecksum;
+};
+
+// Set while recording (--record) or replaying (--replay), otherwise null
+extern InputLog* inputRecording;
+extern const char* recordingPath;
+extern InputReplay* inputReplay;
+
+// Write the recording to recordingPath, if one is running
+void saveRecording();
+
+#endif
@@ -0,0 +1,371 @@
+#include "kociemba_solver.h"
+#include "cubie_cube.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+KociembaSolver* kociembaSolver = nullptr;
+
+namespace {
+
+const char TABLE_MAGIC[8] = {'R', 'C', 'K', 'O', 'C', 'I', 'E', 'M'};
+const uint32_t TABLE_VERSION = 1;
+
+const int TWIST_COUNT = 2187;
+const int FLIP_COUNT = 2048;
+const int SLICE_COUNT = 495;        // positions of the 4 UD-slice edges, order ignored
+const int PERM_COUNT = 40320;       // corner permutation, UD edge permutation
+const int SLICE_PERM_COUNT = 24;    // order of the slice edges inside the slice
+const int PHASE1_MOVES = FACE_MOVE_COUNT;
+const int PHASE2_MOVES = 10;
+
+// Face moves allowed in phase 2: U, U2, U', R2, F2, D, D2, D', L2, B2
+const int phase2Move[PHASE2_MOVES] = {0, 1, 2, 4, 7, 9, 10, 11, 13, 16};
+
+const uint8_t UNVISITED = 0xFF;
+
+int binomial(int n, int k) {
+    if (k < 0 || k > n) return 0;
+    int result = 1;
+    for (int i = 0; i < k; i++) {
+        result = result * (n - i) / (i + 1);
+    }
+    return result;
+}
+
+bool isPhase2Move(int faceMove) {
+    for (int i = 0; i < PHASE2_MOVES; i++) {
+        if (phase2Move[i] == faceMove) return true;
+    }
+    return false;
+}
+
+bool sameOrEarlierAxis(int face, int lastFace) {
+    return lastFace >= 0 && (face == lastFace || (face % 3 == lastFace % 3 && face < lastFace));
+}
+
+// Which positions hold the slice edges FR, FL, BL, BR (0 when they are home)
+int sliceCoordinate(const CubieCube& cube) {
+    int index = 0;
+    int found = 0;
+    for (int j = 11; j >= 0; j--) {
+        if (cube.ep[j] >= FR) {
+            index += binomial(11 - j, found + 1);
+            found++;
+        }
+    }
+    return index;
+}
+
+void setSliceCoordinate(CubieCube& cube, int index) {
+    bool isSlice[12] = {false};
+    for (int i = 3; i >= 0; i--) {
+        int k = i;
+        while (binomial(k + 1, i + 1) <= index) k++;
+        index -= binomial(k, i + 1);
+        isSlice[11 - k] = true;
+    }
+    int nextSlice = FR;
+    int nextOther = UR;
+    for (int j = 0; j < 12; j++) {
+        cube.ep[j] = (uint8_t)(isSlice[j] ? nextSlice++ : nextOther++);
+        cube.eo[j] = 0;
+    }
+}
+
+int udEdgeCoordinate(const CubieCube& cube) {
+    return rankPermutation(cube.ep, 8);
+}
+
+int slicePermCoordinate(const CubieCube& cube) {
+    uint8_t perm[4];
+    for (int i = 0; i < 4; i++) {
+        perm[i] = (uint8_t)(cube.ep[FR + i] - FR);
+    }
+    return rankPermutation(perm, 4);
+}
+
+// Build table[coordinate * moveCount + move] from a coordinate setter and getter
+template <class Set, class Get>
+void fillMoveTable(vector<uint16_t>& table, int count, int moveCount, const int* moves, Set set, Get get) {
+    table.resize((size_t)count * moveCount);
+    for (int i = 0; i < count; i++) {
+        for (int m = 0; m < moveCount; m++) {
+            CubieCube cube;
+            set(cube, i);
+            cube.multiply(faceMoveCube(moves ? moves[m] : m));
+            table[(size_t)i * moveCount + m] = (uint16_t)get(cube);
+        }
+    }
+}
+
+// Breadth-first distances over the pair (a, b), index = a * countB + b, goal at 0
+void fillPruneTable(vector<uint8_t>& table, int countA, int countB, int moveCount,
+                    const uint16_t* moveA, const uint16_t* moveB) {
+    table.assign((size_t)countA * countB, UNVISITED);
+    table[0] = 0;
+    for (int depth = 0;; depth++) {
+        bool added = false;
+        for (size_t index = 0; index < table.size(); index++) {
+            if (table[index] != depth) continue;
+            int a = (int)(index / countB);
+            int b = (int)(index % countB);
+            for (int m = 0; m < moveCount; m++) {
+                size_t next = (size_t)moveA[a * moveCount + m] * countB + moveB[b * moveCount + m];
+                if (table[next] == UNVISITED) {
+                    table[next] = (uint8_t)(depth + 1);
+                    added = true;
+                }
+            }
+        }
+        if (!added) break;
+    }
+}
+
+vector<size_t> tableSizes() {
+    vector<size_t> sizes;
+    sizes.push_back((size_t)TWIST_COUNT * PHASE1_MOVES * sizeof(uint16_t));
+    sizes.push_back((size_t)FLIP_COUNT * PHASE1_MOVES * sizeof(uint16_t));
+    sizes.push_back((size_t)SLICE_COUNT * PHASE1_MOVES * sizeof(uint16_t));
+    sizes.push_back((size_t)PERM_COUNT * PHASE2_MOVES * sizeof(uint16_t));
+    sizes.push_back((size_t)PERM_COUNT * PHASE2_MOVES * sizeof(uint16_t));
+    sizes.push_back((size_t)SLICE_PERM_COUNT * PHASE2_MOVES * sizeof(uint16_t));
+    sizes.push_back((size_t)SLICE_COUNT * TWIST_COUNT);
+    sizes.push_back((size_t)SLICE_COUNT * FLIP_COUNT);
+    sizes.push_back((size_t)SLICE_PERM_COUNT * PERM_COUNT);
+    sizes.push_back((size_t)SLICE_PERM_COUNT * PERM_COUNT);
+    return sizes;
+}
+
+} // namespace
+
+// State of one solve: both phases share the move path. The first solution
+// found only sets a bound; the search goes on for shorter ones, each lowering
+// maxLength, until the phase 1 lengths run out or the node budget is spent.
+struct TwoPhaseSearch {
+    const KociembaSolver* solver;
+    const atomic<bool>* cancel;
+    SolverProgress* progress;
+    CubieCube start;
+    int maxLength;
+    unsigned long long improveNodes;  // nodes allowed after the first solution
+    unsigned long long nodes;
+    unsigned long long nodeLimit;     // set by the first solution
+    bool stopped;
+    bool cancelled;
+    uint8_t path[32];
+    uint8_t best[32];
+    int length;                       // of best, 0 until a solution is found
+
+    TwoPhaseSearch(const KociembaSolver* s, const atomic<bool>* c, SolverProgress* p, const CubieCube& cube, int limit,
+                   unsigned long long improve)
+        : solver(s), cancel(c), progress(p), start(cube), maxLength(limit), improveNodes(improve), nodes(0),
+          nodeLimit(0), stopped(false), cancelled(false), length(0) {}
+
+    bool checkStop() {
+        if ((++nodes & 0xFFF) == 0) {
+            if (progress) progress->nodes.fetch_add(0x1000, memory_order_relaxed);
+            if (cancel && cancel->load(memory_order_relaxed)) stopped = cancelled = true;
+            if (length > 0 && nodes >= nodeLimit) stopped = true;
+        }
+        return stopped;
+    }
+
+    int phase1Bound(int twist, int flip, int slice) const {
+        int a = solver->sliceTwistPrune[slice * TWIST_COUNT + twist];
+        int b = solver->sliceFlipPrune[slice * FLIP_COUNT + flip];
+        return a > b ? a : b;
+    }
+
+    int phase2Bound(int cornerPerm, int udEdge, int slicePerm) const {
+        int a = solver->sliceCornerPrune[slicePerm * PERM_COUNT + cornerPerm];
+        int b = solver->sliceEdgePrune[slicePerm * PERM_COUNT + udEdge];
+        return a > b ? a : b;
+    }
+
+    // True if a solution was found (best, length) and the search not cancelled
+    bool run() {
+        int twist = start.twist();
+        int flip = start.flip();
+        int slice = sliceCoordinate(start);
+        for (int depth1 = phase1Bound(twist, flip, slice); depth1 <= maxLength && !stopped; depth1++) {
+            if (progress) progress->depth.store(depth1, memory_order_relaxed);
+            phase1(twist, flip, slice, 0, depth1, -1);
+        }
+        return length > 0 && !cancelled;
+    }
+
+    bool phase1(int twist, int flip, int slice, int depth, int togo, int lastFace) {
+        if (depth + togo > maxLength) return false;  // a shorter solution turned up
+        if (togo == 0) {
+            // A phase 1 solution ending in a phase 2 move was already tried one level up
+            if (depth > 0 && isPhase2Move(path[depth - 1])) return false;
+            return startPhase2(depth);
+        }
+        for (int face = 0; face < 6; face++) {
+            if (sameOrEarlierAxis(face, lastFace)) continue;
+            for (int power = 0; power < 3; power++) {
+                int m = face * 3 + power;
+                int nextTwist = solver->twistMove[twist * PHASE1_MOVES + m];
+                int nextFlip = solver->flipMove[flip * PHASE1_MOVES + m];
+                int nextSlice = solver->sliceMove[slice * PHASE1_MOVES + m];
+                if (checkStop()) return false;
+                if (phase1Bound(nextTwist, nextFlip, nextSlice) > togo - 1) continue;
+                path[depth] = (uint8_t)m;
+                if (phase1(nextTwist, nextFlip, nextSlice, depth + 1, togo - 1, face)) return true;
+                if (stopped) return false;
+            }
+        }
+        return false;
+    }
+
+    bool startPhase2(int depth1) {
+        CubieCube cube = start;
+        for (int i = 0; i < depth1; i++) {
+            cube.multiply(faceMoveCube(path[i]));
+        }
+        int cornerPerm = cube.cornerPermutation();
+        int udEdge = udEdgeCoordinate(cube);
+        int slicePerm = slicePermCoordinate(cube);
+        int lastFace = depth1 > 0 ? path[depth1 - 1] / 3 : -1;
+
+        // The shortest phase 2 for this phase 1 path; false to keep searching
+        for (int depth2 = phase2Bound(cornerPerm, udEdge, slicePerm); depth1 + depth2 <= maxLength; depth2++) {
+            if (phase2(cornerPerm, udEdge, slicePerm, depth1, depth2, lastFace)) {
+                if (length == 0) nodeLimit = nodes + improveNodes;
+                length = depth1 + depth2;
+                memcpy(best, path, length);
+                maxLength = length - 1;
+                return false;
+            }
+            if (stopped) return false;
+        }
+        return false;
+    }
+
+    bool phase2(int cornerPerm, int udEdge, int slicePerm, int depth, int togo, int lastFace) {
+        if (togo == 0) return true;
+        for (int i = 0; i < PHASE2_MOVES; i++) {
+            int m = phase2Move[i];
+            int face = m / 3;
+            if (sameOrEarlierAxis(face, lastFace)) continue;
+            int nextCorner = solver->cornerPermMove[cornerPerm * PHASE2_MOVES + i];
+            int nextEdge = solver->udEdgeMove[udEdge * PHASE2_MOVES + i];
+            int nextSlice = solver->slicePermMove[slicePerm * PHASE2_MOVES + i];
+            if (checkStop()) return false;
+            if (phase2Bound(nextCorner, nextEdge, nextSlice) > togo - 1) continue;
+            path[depth] = (uint8_t)m;
+            if (phase2(nextCorner, nextEdge, nextSlice, depth + 1, togo - 1, face)) return true;
+            if (stopped) return false;
+        }
+        return false;
+    }
+};
+
+KociembaSolver::KociembaSolver()
+    : ready(false), twistMove(nullptr), flipMove(nullptr), sliceMove(nullptr),
+      cornerPermMove(nullptr), udEdgeMove(nullptr), slicePermMove(nullptr),
+      sliceTwistPrune(nullptr), sliceFlipPrune(nullptr), sliceCornerPrune(nullptr), sliceEdgePrune(nullptr) {
+}
+
+bool KociembaSolver::init(const string& tablePath) {
+    if (ready) return true;
+    if (!mapTables(tablePath)) {
+        cout << "Building two-phase solver tables (one time)..." << endl;
+        buildTables();
+        if (!saveTables(tablePath)) {
+            cout << "Could not write " << tablePath << ", tables will be rebuilt next time" << endl;
+        }
+        useBuiltTables();
+    }
+    ready = true;
+    return true;
+}
+
+void KociembaSolver::buildTables() {
+    fillMoveTable(builtMoves[0], TWIST_COUNT, PHASE1_MOVES, nullptr,
+                  [](CubieCube& c, int i) { c.setTwist(i); },
+                  [](const CubieCube& c) { return c.twist(); });
+    fillMoveTable(builtMoves[1], FLIP_COUNT, PHASE1_MOVES, nullptr,
+                  [](CubieCube& c, int i) { c.setFlip(i); },
+                  [](const CubieCube& c) { return c.flip(); });
+    fillMoveTable(builtMoves[2], SLICE_COUNT, PHASE1_MOVES, nullptr,
+                  [](CubieCube& c, int i) { setSliceCoordinate(c, i); },
+                  [](const CubieCube& c) { return sliceCoordinate(c); });
+    fillMoveTable(builtMoves[3], PERM_COUNT, PHASE2_MOVES, phase2Move,
+                  [](CubieCube& c, int i) { c.setCornerPermutation(i); },
+                  [](const CubieCube& c) { return c.cornerPermutation(); });
+    fillMoveTable(builtMoves[4], PERM_COUNT, PHASE2_MOVES, phase2Move,
+                  [](CubieCube& c, int i) { unrankPermutation(i, c.ep, 8); },
+                  [](const CubieCube& c) { return udEdgeCoordinate(c); });
+    fillMoveTable(builtMoves[5], SLICE_PERM_COUNT, PHASE2_MOVES, phase2Move,
+                  [](CubieCube& c, int i) {
+                      unrankPermutation(i, c.ep + FR, 4);
+                      for (int k = FR; k < 12; k++) c.ep[k] += FR;
+                  },
+                  [](const CubieCube& c) { return slicePermCoordinate(c); });
+
+    fillPruneTable(builtPrune[0], SLICE_COUNT, TWIST_COUNT, PHASE1_MOVES, builtMoves[2].data(), builtMoves[0].data());
+    fillPruneTable(builtPrune[1], SLICE_COUNT, FLIP_COUNT, PHASE1_MOVES, builtMoves[2].data(), builtMoves[1].data());
+    fillPruneTable(builtPrune[2], SLICE_PERM_COUNT, PERM_COUNT, PHASE2_MOVES, builtMoves[5].data(), builtMoves[3].data());
+    fillPruneTable(builtPrune[3], SLICE_PERM_COUNT, PERM_COUNT, PHASE2_MOVES, builtMoves[5].data(), builtMoves[4].data());
+}
+
+void KociembaSolver::useBuiltTables() {
+    twistMove = builtMoves[0].data();
+    flipMove = builtMoves[1].data();
+    sliceMove = builtMoves[2].data();
+    cornerPermMove = builtMoves[3].data();
+    udEdgeMove = builtMoves[4].data();
+    slicePermMove = builtMoves[5].data();
+    sliceTwistPrune = builtPrune[0].data();
+    sliceFlipPrune = builtPrune[1].data();
+    sliceCornerPrune = builtPrune[2].data();
+    sliceEdgePrune = builtPrune[3].data();
+}
+
+bool KociembaSolver::mapTables(const string& path) {
+    if (!tableFile.map(path, TABLE_MAGIC, TABLE_VERSION, tableSizes())) return false;
+
+    twistMove = (const uint16_t*)tableFile.section(0);
+    flipMove = (const uint16_t*)tableFile.section(1);
+    sliceMove = (const uint16_t*)tableFile.section(2);
+    cornerPermMove = (const uint16_t*)tableFile.section(3);
+    udEdgeMove = (const uint16_t*)tableFile.section(4);
+    slicePermMove = (const uint16_t*)tableFile.section(5);
+    sliceTwistPrune = tableFile.section(6);
+    sliceFlipPrune = tableFile.section(7);
+    sliceCornerPrune = tableFile.section(8);
+    sliceEdgePrune = tableFile.section(9);
+    return true;
+}
+
+bool KociembaSolver::saveTables(const string& path) const {
+    vector<TableFile::Section> sections;
+    for (int i = 0; i < 6; i++) {
+        sections.push_back(TableFile::Section(builtMoves[i].data(), builtMoves[i].size() * sizeof(uint16_t)));
+    }
+    for (int i = 0; i < 4; i++) {
+        sections.push_back(TableFile::Section(builtPrune[i].data(), builtPrune[i].size()));
+    }
+    return TableFile::write(path, TABLE_MAGIC, TABLE_VERSION, sections);
+}
+
+bool KociembaSolver::solve(const CubeState& state, vector<int>& solution, const Options& options) const {
+    solution.clear();
+    if (!ready) return false;
+
+    CubieCube cube;
+    if (!cube.fromState(state)) return false;
+    if (cube.isSolved()) return true;
+
+    TwoPhaseSearch search(this, options.cancel, options.progress, cube, options.maxLength < 30 ? options.maxLength : 30,
+                          options.improveNodes);
+    if (!search.run()) return false;
+
+    for (int i = 0; i < search.length; i++) {
+        solution.push_back(faceMoveToStateMove(search.best[i]));
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef KOCIEMBA_SOLVER_H
+#define KOCIEMBA_SOLVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cube_state.h"
+#include "solver_progress.h"
+#include "table_file.h"
+
+// Fast near-optimal solver using Kociemba's two-phase algorithm.
+//
+// Phase 1 brings the cube into the subgroup <U, D, R2, F2, L2, B2> using the
+// twist, flip and UD-slice coordinates; phase 2 solves it inside that group
+// using corner, UD-edge and slice permutations. Both phases are IDA* searches
+// over coordinate move tables with pruning tables as the heuristic.
+//
+// The tables are built once and written to a versioned table file, which is
+// mapped on later runs so startup costs almost nothing.
+class KociembaSolver {
+public:
+    struct Options {
+        int maxLength;                   // longest solution accepted
+        unsigned long long improveNodes; // search nodes spent on shorter solutions after the first
+        const std::atomic<bool>* cancel; // optional, checked while searching
+        SolverProgress* progress;        // optional: the phase 1 length being tried and the node count
+
+        Options() : maxLength(21), improveNodes(1 << 20), cancel(nullptr), progress(nullptr) {}
+    };
+
+    KociembaSolver();
+
+    // Map the tables from tablePath, or build and save them
+    bool init(const std::string& tablePath);
+    bool isReady() const { return ready; }
+
+    // Solve the state; the solution is a list of CubeState moves, the shortest
+    // found within improveNodes of the first. Returns false if cancelled, if no
+    // solution of at most maxLength moves exists or if the state is not a
+    // valid cube.
+    bool solve(const CubeState& state, std::vector<int>& solution,
+               const Options& options = Options()) const;
+
+private:
+    bool ready;
+
+    // Move tables, [coordinate][move] (18 moves in phase 1, 10 in phase 2)
+    const uint16_t* twistMove;
+    const uint16_t* flipMove;
+    const uint16_t* sliceMove;
+    const uint16_t* cornerPermMove;
+    const uint16_t* udEdgeMove;
+    const uint16_t* slicePermMove;
+
+    // Pruning tables, distance to the phase goal per coordinate pair
+    const uint8_t* sliceTwistPrune;
+    const uint8_t* sliceFlipPrune;
+    const uint8_t* sliceCornerPrune;
+    const uint8_t* sliceEdgePrune;
+
+    std::vector<uint16_t> builtMoves[6];  // only used when the tables were built in this run
+    std::vector<uint8_t> builtPrune[4];
+    TableFile tableFile;
+
+    void buildTables();
+    bool mapTables(const std::string& path);
+    bool saveTables(const std::string& path) const;
+    void useBuiltTables();
+
+    friend struct TwoPhaseSearch;
+};
+
+// Global two-phase solver instance
+extern KociembaSolver* kociembaSolver;
+
+#endif
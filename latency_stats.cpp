@@ -0,0 +1,117 @@
+#include "latency_stats.h"
+#include <GL/glut.h>
+#include <cstdio>
+
+LatencyStats* latencyStats = nullptr;
+
+namespace {
+
+const char* sourceNames[LatencyStats::SOURCE_COUNT] = {"keyboard", "mouse button", "mouse motion"};
+
+const double PERCENTILES[] = {50.0, 75.0, 90.0, 95.0, 99.0, 99.9, 100.0};
+
+uint64_t microsecondsBetween(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+    long long micros = std::chrono::duration_cast<std::chrono::microseconds>(b - a).count();
+    return micros > 0 ? (uint64_t)micros : 0;
+}
+
+} // namespace
+
+const int LatencyHistogram::EXACT;
+const int LatencyHistogram::HALF;
+const int LatencyHistogram::SHIFTS;
+const int LatencyHistogram::BUCKET_COUNT;
+
+LatencyHistogram::LatencyHistogram() : counts(BUCKET_COUNT, 0), total(0), sum(0), largest(0) {
+}
+
+// Below EXACT a value is its own bucket. Above, the shift that brings it into
+// [HALF, EXACT) picks the power of two and the shifted value the bucket in it.
+int LatencyHistogram::bucketOf(uint64_t micros) {
+    if (micros < (uint64_t)EXACT) return (int)micros;
+    int shift = 1;
+    while ((micros >> shift) >= (uint64_t)EXACT) shift++;
+    if (shift > SHIFTS) return BUCKET_COUNT - 1;
+    return EXACT + (shift - 1) * HALF + (int)(micros >> shift) - HALF;
+}
+
+uint64_t LatencyHistogram::bucketTop(int bucket) {
+    if (bucket < EXACT) return (uint64_t)bucket;
+    int shift = (bucket - EXACT) / HALF + 1;
+    uint64_t top = (uint64_t)((bucket - EXACT) % HALF + HALF);
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    counts[bucketOf(micros)]++;
+    total++;
+    sum += micros;
+    if (micros > largest) largest = micros;
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percent) const {
+    if (total == 0) return 0;
+    double wanted = total * percent / 100.0;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKET_COUNT; b++) {
+        seen += counts[b];
+        if (seen > 0 && seen >= wanted) {
+            uint64_t top = bucketTop(b);
+            return top < largest ? top : largest;
+        }
+    }
+    return largest;
+}
+
+LatencyStats::LatencyStats(bool finish) : finishFrames(finish), frameScheduled(false), frames(0) {
+    for (int s = 0; s < SOURCE_COUNT; s++) {
+        scheduledEvents[s] = 0;
+    }
+}
+
+void LatencyStats::inputArrived(Source source) {
+    Stamp stamp;
+    stamp.source = source;
+    stamp.arrived = Clock::now();
+    waiting.push_back(stamp);
+    glutPostRedisplay();
+}
+
+void LatencyStats::beginFrame(bool scheduled) {
+    frameStart = Clock::now();
+    frameScheduled = scheduled;
+    drawing.swap(waiting);
+    waiting.clear();
+}
+
+void LatencyStats::endFrame() {
+    if (finishFrames) glFinish();
+    Clock::time_point shown = Clock::now();
+    frames++;
+    for (size_t i = 0; i < drawing.size(); i++) {
+        const Stamp& stamp = drawing[i];
+        total[stamp.source].record(microsecondsBetween(stamp.arrived, shown));
+        queue[stamp.source].record(microsecondsBetween(stamp.arrived, frameStart));
+        render[stamp.source].record(microsecondsBetween(frameStart, shown));
+        if (frameScheduled) scheduledEvents[stamp.source]++;
+    }
+    drawing.clear();
+}
+
+void LatencyStats::printReport() const {
+    printf("\nInput-to-photon latency over %llu frames (until %s)\n", (unsigned long long)frames,
+           finishFrames ? "glFinish after the swap" : "the swap returns");
+    for (int s = 0; s < SOURCE_COUNT; s++) {
+        if (total[s].count() == 0) continue;
+        printf("%s: %llu events, mean %.3f ms (queue %.3f + render %.3f), %llu shown by a timer frame\n",
+               sourceNames[s], (unsigned long long)total[s].count(), total[s].mean() / 1000.0,
+               queue[s].mean() / 1000.0, render[s].mean() / 1000.0, (unsigned long long)scheduledEvents[s]);
+        printf("  %10s %10s %10s %10s\n", "percentile", "total ms", "queue ms", "render ms");
+        for (size_t p = 0; p < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); p++) {
+            printf("  %10.1f %10.3f %10.3f %10.3f\n", PERCENTILES[p],
+                   total[s].valueAtPercentile(PERCENTILES[p]) / 1000.0,
+                   queue[s].valueAtPercentile(PERCENTILES[p]) / 1000.0,
+                   render[s].valueAtPercentile(PERCENTILES[p]) / 1000.0);
+        }
+    }
+}
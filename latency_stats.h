@@ -0,0 +1,102 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Histogram of microsecond values in log-linear buckets, as HdrHistogram
+// does it: exact below 32 µs, then 16 buckets per power of two, so any
+// value is kept within about 6% and the whole range up to an hour fits in
+// 464 counters. Adding a value costs a few shifts and one increment.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return largest; }
+    double mean() const { return total ? (double)sum / total : 0.0; }
+
+    // Smallest bucket top that at least percent of the values are within
+    uint64_t valueAtPercentile(double percent) const;
+
+private:
+    static const int EXACT = 32;                    // values below are their own bucket
+    static const int HALF = EXACT / 2;              // buckets per power of two above
+    static const int SHIFTS = 27;                   // up to 2^32 µs
+    static const int BUCKET_COUNT = EXACT + SHIFTS * HALF;
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t sum;
+    uint64_t largest;
+
+    static int bucketOf(uint64_t micros);
+    static uint64_t bucketTop(int bucket);
+};
+
+// Input-to-photon latency: how long after an input event arrives the frame
+// showing its effect is on screen.
+//
+// The input handlers stamp each event as it enters (and ask for a redraw, so
+// every event gets a frame even if it changed nothing). display() marks the
+// frame start, taking every event stamped since into that frame, and the end
+// after glutSwapBuffers, optionally after glFinish so the GPU's work is
+// included. Each event's latency is split into queue time, from its stamp to
+// the start of the frame (the wait for the event loop, or for the 16 ms frame
+// timer while a turn plays), and render time, from there to the swap.
+// Histograms are kept per source and printed on exit or with the I key.
+class LatencyStats {
+public:
+    enum Source {
+        KEYBOARD = 0,
+        MOUSE,
+        MOTION,
+        SOURCE_COUNT
+    };
+
+    explicit LatencyStats(bool finishFrames);
+
+    void inputArrived(Source source);
+
+    // Frame bracketing in display(); scheduled is true for a frame started by
+    // the frame timer rather than straight from a redisplay request
+    void beginFrame(bool scheduled);
+    void endFrame();
+
+    void printReport() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Stamp {
+        Source source;
+        Clock::time_point arrived;
+    };
+
+    bool finishFrames;
+    std::vector<Stamp> waiting;   // no frame started since they arrived
+    std::vector<Stamp> drawing;   // shown by the frame being drawn
+    Clock::time_point frameStart;
+    bool frameScheduled;
+    uint64_t frames;
+
+    LatencyHistogram total[SOURCE_COUNT];
+    LatencyHistogram queue[SOURCE_COUNT];
+    LatencyHistogram render[SOURCE_COUNT];
+    uint64_t scheduledEvents[SOURCE_COUNT];  // shown by a timer frame
+};
+
+// Set with --latency, otherwise null
+extern LatencyStats* latencyStats;
+
+// Stamp an input event, if latency is being measured
+inline void stampInput(LatencyStats::Source source) {
+    if (latencyStats) {
+        latencyStats->inputArrived(source);
+    }
+}
+
+#endif
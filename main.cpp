@@ -1,39 +1,126 @@
-#include <GL/glut.h>
+#include <GL/freeglut.h>
 #include <iostream>
 #include "cube.h"
 #include "input_handler.h"
+#include "kociemba_solver.h"
+#include "batch_verifier.h"
+#include "headless_render.h"
+#include "state_enumerator.h"
+#include "frame_stats.h"
+#include "shader_pipeline.h"
+#include "move_journal.h"
+#include "cube_wall.h"
+#include "async_solver.h"
+#include "input_log.h"
+#include "latency_stats.h"
+#include <cstring>
+#include <cstdlib>
 
 using namespace std;
 
+// Redraw scheduling: frames are only drawn when something changed. Input
+// handlers post a redisplay themselves; while a turn plays, display() asks for
+// the next frame about 16 ms after the start of the current one.
+const double FRAME_INTERVAL = 1.0 / 60.0;
+bool frameScheduled = false;
+bool timerFrame = false;  // the frame timer asked for this frame
+
+void timer(int value) {
+    frameScheduled = false;
+    timerFrame = true;
+    glutPostRedisplay();
+}
+
+void scheduleNextFrame(double frameStart) {
+    if (frameScheduled) return;
+    double wait = frameStart + FRAME_INTERVAL - animationClock();
+    frameScheduled = true;
+    glutTimerFunc(wait > 0.0 ? (unsigned)(wait * 1000.0) : 0, timer, 0);
+}
+
+// Replay: a timer tick starts each frame by moving the virtual clock on and
+// dispatching the recorded input due by then; the display() that follows
+// finishes it. Redraws in between (expose, a handler's redisplay) do not count.
+bool replayFrameDue = false;
+bool replayEventsLeft = true;
+
+void replayTick(int value) {
+    replayEventsLeft = inputReplay->advance();
+    replayFrameDue = true;
+    glutPostRedisplay();
+}
+
+void finishReplayFrame() {
+    replayFrameDue = false;
+    uint64_t hash = rubiksCube ? rubiksCube->getHash() : 0;
+    inputReplay->endFrame(hash, *camera);
+    if (replayEventsLeft || isAnimating() || isSolving()) {
+        glutTimerFunc((unsigned)(inputReplay->nextFrameDelay() * 1000.0), replayTick, 0);
+        return;
+    }
+
+    inputReplay->printSummary(hash, *camera);
+    if (latencyStats) latencyStats->printReport();
+    delete asyncSolver;
+    delete frameStats;  // flushes the stats CSV
+    exit(0);
+}
+
 void display() {
+    double frameStart = animationClock();
+    if (latencyStats) latencyStats->beginFrame(timerFrame);
+    timerFrame = false;
+    if (frameStats) frameStats->beginFrame();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    
     // Apply camera transformation
-    if (camera) {
-        camera->apply();
+    if (shaderPipeline) {
+        if (camera) shaderPipeline->beginFrame(*camera);
+    } else {
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+        if (camera) camera->apply();
     }
+    if (frameStats) frameStats->endStage(FrameStats::STAGE_CAMERA);
     
     // Update animations
     updateLayerAnimation();
+    if (frameStats) frameStats->endStage(FrameStats::STAGE_ANIMATION);
     
-    // Draw the Rubik's cube
-    if (rubiksCube) {
+    // Draw the Rubik's cube, or the wall of states in its place
+    if (cubeWall) {
+        if (camera) cubeWall->draw(*camera);
+    } else if (rubiksCube) {
         rubiksCube->draw();
     }
+    if (frameStats) {
+        frameStats->endStage(FrameStats::STAGE_DRAW);
+        frameStats->drawOverlay();
+    }
     
     glutSwapBuffers();
-}
-
-void timer(int value) {
-    glutPostRedisplay();
-    glutTimerFunc(16, timer, 0); // ~60 FPS
+    if (frameStats) frameStats->endFrame();
+    if (latencyStats) latencyStats->endFrame();
+    
+    // Keep drawing only while something moves (or a solve reports progress)
+    if (inputReplay) {
+        if (replayFrameDue) finishReplayFrame();
+    } else if (isAnimating() || isSolving()) {
+        scheduleNextFrame(frameStart);
+    }
 }
 
 void initGL() {
     glEnable(GL_DEPTH_TEST);
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    if (shaderPipeline) {
+        // Lighting lives in the shaders; fall back to fixed function if they fail
+        if (shaderPipeline->init()) return;
+        delete shaderPipeline;
+        shaderPipeline = nullptr;
+    }
+
     glEnable(GL_LIGHTING);
     glEnable(GL_LIGHT0);
     
@@ -51,31 +138,141 @@ void initGL() {
     // Enable color material
     glEnable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
-    
-    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
 }
 
 void reshape(int w, int h) {
+    if (inputRecording) inputRecording->add(InputLog::RESHAPE, 0, 0, 0, w, h);
     glViewport(0, 0, w, h);
+    if (camera && !inputReplay) camera->setViewport(w, h);  // a replay sets the recorded size
+    if (shaderPipeline) return;  // projection comes from the camera's matrices
+
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(45.0, (double)w / (double)h, 1.0, 100.0);
+    // Far plane past the furthest zoom so large cubes are not clipped
+    double farPlane = camera ? camera->getFarPlane() : 100.0;
+    double fieldOfView = camera ? camera->getFieldOfView() : 45.0;
+    gluPerspective(fieldOfView, (double)w / (double)h, 1.0, farPlane);
 }
 
+// Live input is recorded with --record and ignored during a replay, except
+// for ESC which always quits (and is never recorded)
 void mouse(int button, int state, int x, int y) {
+    if (inputReplay) return;
+    if (inputRecording) inputRecording->add(InputLog::MOUSE, button, state, 0, x, y);
     handleMouse(button, state, x, y);
 }
 
 void mouseMotion(int x, int y) {
+    if (inputReplay) return;
+    if (inputRecording) inputRecording->add(InputLog::MOTION, 0, 0, 0, x, y);
     handleMouseMotion(x, y);
 }
 
 void keyboard(unsigned char key, int x, int y) {
-    handleKeyboard(key, x, y);
+    int modifiers = glutGetModifiers();
+    if (key != 27) {
+        if (inputReplay) return;
+        if (inputRecording) inputRecording->add(InputLog::KEYBOARD, key, 0, modifiers, x, y);
+    }
+    handleKeyboard(key, x, y, modifiers);
+}
+
+void closeWindow() {
+    saveJournal();
+    saveRecording();
+    if (latencyStats) latencyStats->printReport();
 }
 
 int main(int argc, char** argv) {
+    // Headless modes, no window
+    if (argc > 1 && strcmp(argv[1], "--verify") == 0) {
+        return runBatchVerifier(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--render-bench") == 0) {
+        return runRenderBenchmark(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--render") == 0) {
+        return runHeadlessRender(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--enumerate") == 0) {
+        return runEnumeration(argc - 2, argv + 2);
+    }
+
+    // Cube size: --size N (2..NxNCubeState::MAX_SIZE)
+    // Frame stats: --hud shows the overlay, --stats-csv FILE streams every frame
+    // Animation: --turn-time SECONDS per quarter turn
+    // Rendering: --core asks for a GL 3.3 core context and the shader pipeline
+    // History: --journal FILE resumes the session saved there and saves it on exit
+    // Input: --record FILE saves every input event on exit; --replay FILE plays
+    // them back at --replay-speed 1 (as recorded), N times faster or max
+    // Latency: --latency measures input-to-photon latency, --latency-finish
+    // also waits for the GPU (glFinish) before a frame counts as shown
+    int size = 3;
+    bool showHud = false;
+    bool core = false;
+    const char* statsCsv = nullptr;
+    const char* replayPath = nullptr;
+    double replaySpeed = 1.0;
+    bool latency = false;
+    bool latencyFinish = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--stats-csv") == 0 && i + 1 < argc) {
+            statsCsv = argv[++i];
+        } else if (strcmp(argv[i], "--turn-time") == 0 && i + 1 < argc) {
+            double seconds = atof(argv[++i]);
+            if (seconds > 0.0) turnDuration = seconds;
+        } else if (strcmp(argv[i], "--hud") == 0) {
+            showHud = true;
+        } else if (strcmp(argv[i], "--core") == 0) {
+            core = true;
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journalPath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordingPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            i++;
+            replaySpeed = strcmp(argv[i], "max") == 0 ? 0.0 : atof(argv[i]);
+            if (replaySpeed < 0.0) replaySpeed = 1.0;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            latency = true;
+        } else if (strcmp(argv[i], "--latency-finish") == 0) {
+            latency = true;
+            latencyFinish = true;
+        }
+    }
+
+    // A recording or replay starts from a fresh cube, so it never resumes a
+    // journal; a replay takes the recording's cube size and turn time
+    InputLog replayLog;
+    if (replayPath) {
+        if (!replayLog.load(replayPath)) {
+            cerr << "Cannot read input recording " << replayPath << endl;
+            return 1;
+        }
+        size = replayLog.getCubeSize();
+        turnDuration = replayLog.getTurnDuration();
+        recordingPath = nullptr;
+    }
+    if ((replayPath || recordingPath) && journalPath) {
+        cerr << "Ignoring --journal while recording or replaying input" << endl;
+        journalPath = nullptr;
+    }
+    if (size < NxNCubeState::MIN_SIZE || size > NxNCubeState::MAX_SIZE) {
+        cerr << "Cube size must be between " << NxNCubeState::MIN_SIZE << " and "
+             << NxNCubeState::MAX_SIZE << endl;
+        return 1;
+    }
+
     glutInit(&argc, argv);
+    if (core) {
+        glutInitContextVersion(3, 3);
+        glutInitContextProfile(GLUT_CORE_PROFILE);
+        shaderPipeline = new ShaderPipeline();
+    }
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutCreateWindow("Rubik's Cube - Camera Mode");
@@ -85,8 +282,41 @@ int main(int argc, char** argv) {
     initGL();
     
     // Create cube and camera
-    rubiksCube = new RubiksCube();
+    rubiksCube = new RubiksCube(size);
     camera = new Camera();
+    camera->fitToSize(size * 1.1f);
+    
+    // Every turn goes into the journal for undo/redo
+    moveJournal = new MoveJournal(size);
+    if (journalPath) {
+        MoveJournal saved;
+        if (saved.load(journalPath)) {
+            if (saved.getCubeSize() == size) {
+                *moveJournal = saved;
+                rubiksCube->setCube(moveJournal->state());
+                cout << "Resumed " << journalPath << " at turn " << moveJournal->position() << " of "
+                     << moveJournal->size() << endl;
+            } else {
+                cerr << journalPath << " is for a " << saved.getCubeSize() << "x" << saved.getCubeSize()
+                     << " cube; starting a new journal" << endl;
+            }
+        }
+    }
+    
+    frameStats = new FrameStats();
+    frameStats->setOverlayVisible(showHud);
+    if (statsCsv && !frameStats->openCsv(statsCsv)) {
+        cerr << "Cannot write " << statsCsv << endl;
+    }
+    if (latency) {
+        latencyStats = new LatencyStats(latencyFinish);
+    }
+    
+    // Two-phase solver tables are mapped from disk after the first run
+    if (size == 3) {
+        kociembaSolver = new KociembaSolver();
+        kociembaSolver->init("kociemba_tables.bin");
+    }
     
     // Set callback functions
     glutDisplayFunc(display);
@@ -94,14 +324,31 @@ int main(int argc, char** argv) {
     glutMouseFunc(mouse);
     glutMotionFunc(mouseMotion);
     glutKeyboardFunc(keyboard);
+    glutCloseFunc(closeWindow);
     
-    // Set timer for smooth animations
-    glutTimerFunc(16, timer, 0);
+    if (replayPath) {
+        inputReplay = new InputReplay(replayLog, FRAME_INTERVAL, replaySpeed);
+        cout << "Replaying " << replayLog.getEvents().size() << " input events from " << replayPath << endl;
+        glutTimerFunc(0, replayTick, 0);
+    } else if (recordingPath) {
+        inputRecording = new InputLog();
+        inputRecording->start(size, turnDuration);
+        cout << "Recording input to " << recordingPath << endl;
+    }
     
     glutMainLoop();
     
     
+    delete asyncSolver;
     delete rubiksCube;
     delete camera;
+    delete kociembaSolver;
+    delete frameStats;
+    delete cubeWall;
+    delete shaderPipeline;
+    delete moveJournal;
+    delete inputRecording;
+    delete inputReplay;
+    delete latencyStats;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "move_journal.h"
+#include <cstring>
+#include "table_file.h"
+
+MoveJournal* moveJournal = nullptr;
+
+namespace {
+
+const char JOURNAL_MAGIC[8] = {'R', 'C', 'J', 'O', 'U', 'R', 'N', 'L'};
+const uint32_t JOURNAL_VERSION = 1;
+
+struct JournalHeader {
+    uint32_t cubeSize;
+    uint32_t bytesPerTurn;
+    uint64_t snapshotInterval;
+    uint64_t turnCount;
+    uint64_t cursor;
+};
+
+} // namespace
+
+const int MoveJournal::MAX_BYTE_LAYERS;
+
+MoveJournal::MoveJournal(int cubeSize, size_t interval)
+    : current(cubeSize), snapshotInterval(interval > 0 ? interval : 1),
+      bytesPerTurn(current.size() <= MAX_BYTE_LAYERS ? 1 : 3), turnCount(0), cursor(0) {
+    clear();
+}
+
+void MoveJournal::clear() {
+    current.reset();
+    turns.clear();
+    snapshots.clear();
+    turnCount = cursor = 0;
+    takeSnapshot();
+}
+
+void MoveJournal::takeSnapshot() {
+    snapshots.insert(snapshots.end(), current.data(), current.data() + current.faceletCount());
+}
+
+void MoveJournal::encode(size_t index, int axis, int layer, int turn) {
+    uint8_t* bytes = &turns[index * bytesPerTurn];
+    if (bytesPerTurn == 1) {
+        bytes[0] = (uint8_t)((layer * 3 + axis) * 3 + turn);
+    } else {
+        bytes[0] = (uint8_t)(axis * 3 + turn);
+        bytes[1] = (uint8_t)(layer & 0xff);
+        bytes[2] = (uint8_t)(layer >> 8);
+    }
+}
+
+MoveJournal::Turn MoveJournal::turnAt(size_t index) const {
+    const uint8_t* bytes = &turns[index * bytesPerTurn];
+    Turn result;
+    if (bytesPerTurn == 1) {
+        result.turn = bytes[0] % 3;
+        result.axis = bytes[0] / 3 % 3;
+        result.layer = bytes[0] / 9;
+    } else {
+        result.turn = bytes[0] % 3;
+        result.axis = bytes[0] / 3;
+        result.layer = bytes[1] | (bytes[2] << 8);
+    }
+    return result;
+}
+
+void MoveJournal::record(int axis, int layer, int turn) {
+    // A new turn after undo replaces the redo tail and its snapshots
+    if (cursor < turnCount) {
+        turnCount = cursor;
+        turns.resize(turnCount * bytesPerTurn);
+        snapshots.resize((turnCount / snapshotInterval + 1) * current.faceletCount());
+    }
+
+    turns.resize((turnCount + 1) * bytesPerTurn);
+    encode(turnCount, axis, layer, turn);
+    current.turnLayer(axis, layer, turn);
+    turnCount++;
+    cursor++;
+    if (cursor % snapshotInterval == 0) {
+        takeSnapshot();
+    }
+}
+
+bool MoveJournal::undo(Turn& applied) {
+    if (cursor == 0) return false;
+    applied = turnAt(--cursor);
+    applied.turn = 2 - applied.turn;
+    current.turnLayer(applied.axis, applied.layer, applied.turn);
+    return true;
+}
+
+bool MoveJournal::redo(Turn& applied) {
+    if (cursor == turnCount) return false;
+    applied = turnAt(cursor++);
+    current.turnLayer(applied.axis, applied.layer, applied.turn);
+    return true;
+}
+
+bool MoveJournal::seek(size_t position) {
+    if (position > turnCount) return false;
+
+    // Replay from the nearest snapshot, or from the cursor when that is closer
+    size_t from = position / snapshotInterval * snapshotInterval;
+    if (cursor > position || cursor < from) {
+        current.setFacelets(&snapshots[from / snapshotInterval * current.faceletCount()]);
+    } else {
+        from = cursor;
+    }
+    for (size_t i = from; i < position; i++) {
+        Turn step = turnAt(i);
+        current.turnLayer(step.axis, step.layer, step.turn);
+    }
+    cursor = position;
+    return true;
+}
+
+bool MoveJournal::save(const std::string& path) const {
+    JournalHeader header;
+    header.cubeSize = (uint32_t)current.size();
+    header.bytesPerTurn = (uint32_t)bytesPerTurn;
+    header.snapshotInterval = snapshotInterval;
+    header.turnCount = turnCount;
+    header.cursor = cursor;
+
+    std::vector<TableFile::Section> sections;
+    sections.push_back(TableFile::Section(&header, sizeof(header)));
+    sections.push_back(TableFile::Section(turns.data(), turns.size()));
+    sections.push_back(TableFile::Section(snapshots.data(), snapshots.size()));
+    return TableFile::write(path, JOURNAL_MAGIC, JOURNAL_VERSION, sections);
+}
+
+bool MoveJournal::load(const std::string& path) {
+    TableFile file;
+    std::vector<size_t> sizes;
+    sizes.push_back(sizeof(JournalHeader));
+    sizes.push_back(TableFile::ANY_SIZE);
+    sizes.push_back(TableFile::ANY_SIZE);
+    if (!file.map(path, JOURNAL_MAGIC, JOURNAL_VERSION, sizes)) return false;
+
+    JournalHeader header;
+    memcpy(&header, file.section(0), sizeof(header));
+    if (header.cubeSize < NxNCubeState::MIN_SIZE || header.cubeSize > NxNCubeState::MAX_SIZE ||
+        header.snapshotInterval == 0 || header.cursor > header.turnCount) {
+        return false;
+    }
+    size_t expectedBytes = header.cubeSize <= MAX_BYTE_LAYERS ? 1 : 3;
+    size_t faceletCount = 6 * (size_t)header.cubeSize * header.cubeSize;
+    if (header.bytesPerTurn != expectedBytes || file.sectionSize(1) != header.turnCount * expectedBytes ||
+        file.sectionSize(2) != (header.turnCount / header.snapshotInterval + 1) * faceletCount) {
+        return false;
+    }
+
+    // Every turn must name a real layer, every sticker a real colour
+    const uint8_t* turnBytes = file.section(1);
+    for (size_t i = 0; i < header.turnCount; i++) {
+        const uint8_t* bytes = turnBytes + i * expectedBytes;
+        int layer = expectedBytes == 1 ? bytes[0] / 9 : bytes[1] | (bytes[2] << 8);
+        int axis = expectedBytes == 1 ? bytes[0] / 3 % 3 : bytes[0] / 3;
+        if (layer >= (int)header.cubeSize || axis > 2) return false;
+    }
+    const uint8_t* snapshotBytes = file.section(2);
+    for (size_t i = 0; i < file.sectionSize(2); i++) {
+        if (snapshotBytes[i] >= 6) return false;
+    }
+
+    current = NxNCubeState((int)header.cubeSize);
+    snapshotInterval = header.snapshotInterval;
+    bytesPerTurn = expectedBytes;
+    turnCount = header.turnCount;
+    turns.assign(turnBytes, turnBytes + file.sectionSize(1));
+    snapshots.assign(snapshotBytes, snapshotBytes + file.sectionSize(2));
+    cursor = 0;
+    current.setFacelets(snapshots.data());
+    seek(header.cursor);
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef MOVE_JOURNAL_H
+#define MOVE_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "nxn_cube_state.h"
+
+// Session history of layer turns with undo, redo and seek.
+//
+// Every turn is one byte, (layer * 3 + axis) * 3 + turn, on cubes of up to
+// MAX_BYTE_LAYERS layers; bigger cubes need 3 bytes per turn (the layer as a
+// 16-bit number). The journal keeps the state at its cursor, so undo and redo
+// apply one turn (its inverse for undo) and a turn recorded after an undo
+// drops the redo tail. A full sticker snapshot is kept every snapshotInterval
+// turns, so seeking anywhere restores the nearest snapshot at or before the
+// target and replays at most snapshotInterval - 1 turns.
+//
+// save() writes a TableFile (metadata, turns, snapshots); load() maps it and
+// takes the turns and snapshots over in one copy each.
+class MoveJournal {
+public:
+    static const int MAX_BYTE_LAYERS = 28;
+
+    struct Turn {
+        int axis;
+        int layer;
+        int turn;   // 0 = clockwise, 1 = half, 2 = counter-clockwise
+    };
+
+    explicit MoveJournal(int cubeSize = 3, size_t snapshotInterval = 256);
+
+    // Forget everything; the journal starts from the solved cube
+    void clear();
+
+    // Append a turn at the cursor, dropping any turns after it
+    void record(int axis, int layer, int turn);
+
+    // Step the cursor back or forward one turn. The turn to apply to the cube
+    // to follow is returned (the inverse of the undone turn for undo).
+    bool undo(Turn& applied);
+    bool redo(Turn& applied);
+
+    // Move the cursor to after the first position turns
+    bool seek(size_t position);
+
+    size_t position() const { return cursor; }
+    size_t size() const { return turnCount; }
+    size_t getSnapshotInterval() const { return snapshotInterval; }
+    int getCubeSize() const { return current.size(); }
+
+    // Cube state at the cursor
+    const NxNCubeState& state() const { return current; }
+
+    // Turn at an index (0..size()-1)
+    Turn turnAt(size_t index) const;
+
+    bool save(const std::string& path) const;
+    // Replaces the journal; fails (and leaves it unchanged) on a bad file
+    bool load(const std::string& path);
+
+private:
+    NxNCubeState current;
+    size_t snapshotInterval;
+    size_t bytesPerTurn;
+    size_t turnCount;
+    size_t cursor;
+    std::vector<uint8_t> turns;       // bytesPerTurn per turn
+    std::vector<uint8_t> snapshots;   // stickers after 0, K, 2K, ... turns
+
+    void encode(size_t index, int axis, int layer, int turn);
+    void takeSnapshot();
+};
+
+// Journal of the interactive session, or null
+extern MoveJournal* moveJournal;
+
+#endif
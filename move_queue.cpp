@@ -0,0 +1,42 @@
+#include "move_queue.h"
+
+MoveQueue::MoveQueue(size_t capacity) : turns(capacity > 0 ? capacity : 1), head(0), count(0) {
+}
+
+bool MoveQueue::push(int axis, int layer, int quarters) {
+    quarters = ((quarters % 4) + 4) % 4;
+    if (quarters == 0) return true;
+
+    // Merge with the newest turn if it is on the same layer
+    if (count > 0) {
+        Turn& last = turns[(head + count - 1) % turns.size()];
+        if (last.axis == axis && last.layer == layer) {
+            last.quarters = (last.quarters + quarters) % 4;
+            if (last.quarters == 0) {
+                count--;
+            }
+            return true;
+        }
+    }
+
+    if (full()) return false;
+    Turn& turn = turns[(head + count) % turns.size()];
+    turn.axis = axis;
+    turn.layer = layer;
+    turn.quarters = quarters;
+    count++;
+    return true;
+}
+
+bool MoveQueue::pop(Turn& turn) {
+    if (count == 0) return false;
+    turn = turns[head];
+    head = (head + 1) % turns.size();
+    count--;
+    return true;
+}
+
+void MoveQueue::clear() {
+    head = 0;
+    count = 0;
+}
@@ -0,0 +1,37 @@
+#ifndef MOVE_QUEUE_H
+#define MOVE_QUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+// Bounded FIFO of layer turns waiting to be animated.
+//
+// A turn pushed right after a turn of the same layer is merged into it, so
+// U U plays as U2 and U U' disappears. Only the newest queued turn is merged;
+// the one being animated has already left the queue.
+class MoveQueue {
+public:
+    struct Turn {
+        int axis;
+        int layer;      // 0..N-1 along axis
+        int quarters;   // clockwise quarter turns, 1..3
+    };
+
+    explicit MoveQueue(size_t capacity = 1024);
+
+    // False if the queue is full and the turn could not be merged
+    bool push(int axis, int layer, int quarters);
+    bool pop(Turn& turn);
+    void clear();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == turns.size(); }
+
+private:
+    std::vector<Turn> turns;
+    size_t head;
+    size_t count;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "nxn_cube_state.h"
+#include <cstring>
+
+namespace {
+
+// Right-handed quarter turn about axis, sign = +1 or -1
+void quarterTurn(int* v, int axis, int sign) {
+    int u = (axis + 1) % 3;
+    int w = (axis + 2) % 3;
+    int vu = v[u];
+    int vw = v[w];
+    v[u] = -sign * vw;
+    v[w] = sign * vu;
+}
+
+int dot(const int* a, const int* b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+} // namespace
+
+NxNCubeState::NxNCubeState(int size) : n(size) {
+    if (n < MIN_SIZE) n = MIN_SIZE;
+    if (n > MAX_SIZE) n = MAX_SIZE;
+    facelets.resize(6 * n * n);
+    moveTargets.resize(4 * n + n * n);
+    moveColors.resize(4 * n + n * n);
+    reset();
+}
+
+void NxNCubeState::reset() {
+    int perFace = n * n;
+    for (int face = 0; face < 6; face++) {
+        memset(&facelets[face * perFace], face, perFace);
+    }
+    key = 0;
+    for (int i = 0; i < 6 * perFace; i++) {
+        key ^= CubeState::zobristKey(i, facelets[i]);
+    }
+}
+
+void NxNCubeState::setFacelets(const uint8_t* colors) {
+    memcpy(facelets.data(), colors, facelets.size());
+    key = 0;
+    for (size_t i = 0; i < facelets.size(); i++) {
+        key ^= CubeState::zobristKey((uint32_t)i, facelets[i]);
+    }
+}
+
+bool NxNCubeState::isSolved() const {
+    int perFace = n * n;
+    for (int face = 0; face < 6; face++) {
+        const uint8_t* stickers = &facelets[face * perFace];
+        for (int i = 1; i < perFace; i++) {
+            if (stickers[i] != stickers[0]) return false;
+        }
+    }
+    return true;
+}
+
+// Facelet of the sticker facing outward from face at doubled cubie position p
+// (each coordinate is 2 * index - (N - 1))
+int NxNCubeState::faceletFromPosition(int face, const int* p) const {
+    int col = (dot(p, CubeState::faceColumnAxis(face)) + n - 1) / 2;
+    int row = (dot(p, CubeState::faceRowAxis(face)) + n - 1) / 2;
+    return (face * n + row) * n + col;
+}
+
+void NxNCubeState::turnLayer(int axis, int layer, int turn) {
+    if (n == 3) {
+        // Same layout as CubeState, use its precomputed gather over the moved facelets
+        int move = CubeState::layerIndex(axis, layer - 1) * 3 + turn;
+        int movedCount;
+        const uint8_t* moved = CubeState::movedFacelets(move, movedCount);
+        CubeState::permuteFacelets(facelets.data(), key, CubeState::moveTable(move), moved, movedCount);
+        return;
+    }
+
+    int quarters = turn + 1;
+    int sign = CubeState::clockwiseSign(axis);
+    int count = 0;
+
+    // Strips of the four side faces crossing the layer
+    for (int face = 0; face < 6; face++) {
+        const int* normal = CubeState::faceNormal(face);
+        if (normal[axis] != 0) continue;
+
+        int normalAxis = normal[0] != 0 ? 0 : (normal[1] != 0 ? 1 : 2);
+        int stripAxis = 3 - axis - normalAxis;
+        int target[3] = {normal[0], normal[1], normal[2]};
+        for (int q = 0; q < quarters; q++) {
+            quarterTurn(target, axis, sign);
+        }
+        int targetFace = CubeState::faceFromNormal(target);
+
+        for (int k = 0; k < n; k++) {
+            int p[3];
+            p[axis] = coordinate(layer);
+            p[normalAxis] = normal[normalAxis] * (n - 1);
+            p[stripAxis] = coordinate(k);
+            moveColors[count] = facelets[faceletFromPosition(face, p)];
+            for (int q = 0; q < quarters; q++) {
+                quarterTurn(p, axis, sign);
+            }
+            moveTargets[count++] = faceletFromPosition(targetFace, p);
+        }
+    }
+
+    // The face itself turns with an outer layer
+    if (layer == 0 || layer == n - 1) {
+        int normal[3] = {0, 0, 0};
+        normal[axis] = layer == 0 ? -1 : 1;
+        int face = CubeState::faceFromNormal(normal);
+        const int* colAxis = CubeState::faceColumnAxis(face);
+        const int* rowAxis = CubeState::faceRowAxis(face);
+
+        for (int row = 0; row < n; row++) {
+            for (int col = 0; col < n; col++) {
+                int p[3];
+                for (int a = 0; a < 3; a++) {
+                    p[a] = normal[a] * (n - 1) + colAxis[a] * coordinate(col) + rowAxis[a] * coordinate(row);
+                }
+                moveColors[count] = facelets[(face * n + row) * n + col];
+                for (int q = 0; q < quarters; q++) {
+                    quarterTurn(p, axis, sign);
+                }
+                moveTargets[count++] = faceletFromPosition(face, p);
+            }
+        }
+    }
+
+    // Every target is written once, so its old colour is still in place
+    for (int i = 0; i < count; i++) {
+        int target = moveTargets[i];
+        key ^= CubeState::zobristKey(target, facelets[target]) ^ CubeState::zobristKey(target, moveColors[i]);
+        facelets[target] = moveColors[i];
+    }
+}
+
+int NxNCubeState::faceletAt(int x, int y, int z, int face) const {
+    const int* normal = CubeState::faceNormal(face);
+    int p[3] = {coordinate(x), coordinate(y), coordinate(z)};
+    if (dot(p, normal) != n - 1) return -1;
+    return faceletFromPosition(face, p);
+}
+
+bool NxNCubeState::toCubeState(CubeState& state) const {
+    if (n != 3) return false;
+    state.setFacelets(facelets.data());
+    return true;
+}
+
+void NxNCubeState::fromCubeState(const CubeState& state) {
+    if (n != 3) return;
+    memcpy(facelets.data(), state.data(), CubeState::FACELET_COUNT);
+    key = state.hash();
+}
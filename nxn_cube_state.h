@@ -0,0 +1,73 @@
+#ifndef NXN_CUBE_STATE_H
+#define NXN_CUBE_STATE_H
+
+#include <cstdint>
+#include <vector>
+#include "cube_state.h"
+
+// Facelet state of an NxN cube (2 <= N <= MAX_SIZE).
+//
+// Facelet index = face * N * N + row * N + col, with the same face order and
+// face layouts as CubeState, so a 3x3 NxNCubeState has exactly the CubeState
+// layout. Only the 6 * N * N stickers are stored; there are no interior cubies.
+//
+// A layer is addressed by axis (0 = x, 1 = y, 2 = z) and index 0..N-1 from the
+// negative side. Turning a layer moves 4 * N strip stickers, plus the N * N
+// stickers of the face when it is an outer layer, so a turn is O(N^2) at worst.
+// Turns follow the same clockwise convention as CubeState; 3x3 cubes use the
+// precomputed CubeState move tables.
+//
+// The state keeps a Zobrist hash using CubeState::zobristKey, updated from the
+// moved stickers on every turn; a 3x3 state hashes equal to its CubeState.
+class NxNCubeState {
+private:
+    int n;
+    std::vector<uint8_t> facelets;
+    uint64_t key;
+
+    // Scratch space for a turn: destination index and colour of every moved sticker
+    std::vector<int> moveTargets;
+    std::vector<uint8_t> moveColors;
+
+    int coordinate(int index) const { return 2 * index - (n - 1); }
+    int faceletFromPosition(int face, const int* p) const;
+
+public:
+    static const int MIN_SIZE = 2;
+    static const int MAX_SIZE = 1024;
+
+    explicit NxNCubeState(int size = 3);
+
+    int size() const { return n; }
+    int faceletCount() const { return 6 * n * n; }
+
+    void reset();
+    bool isSolved() const;
+    uint64_t hash() const { return key; }
+
+    // Turn a layer: turn 0 = clockwise, 1 = half turn, 2 = counter-clockwise
+    void turnLayer(int axis, int layer, int turn);
+
+    uint8_t facelet(int index) const { return facelets[index]; }
+    uint8_t facelet(int face, int row, int col) const { return facelets[(face * n + row) * n + col]; }
+    const uint8_t* data() const { return facelets.data(); }
+
+    // Replace every sticker (faceletCount() colours) and rehash
+    void setFacelets(const uint8_t* colors);
+
+    // Same size, equal hashes, then equal stickers
+    bool operator==(const NxNCubeState& other) const {
+        return n == other.n && key == other.key && facelets == other.facelets;
+    }
+    bool operator!=(const NxNCubeState& other) const { return !(*this == other); }
+
+    // Facelet index of the sticker on the given face of the cubie at (x, y, z),
+    // coordinates in 0..N-1, or -1 if that face is inside the cube
+    int faceletAt(int x, int y, int z, int face) const;
+
+    // Conversion to and from the 3x3 engine; toCubeState fails for other sizes
+    bool toCubeState(CubeState& state) const;
+    void fromCubeState(const CubeState& state);
+};
+
+#endif
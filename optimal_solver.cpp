@@ -0,0 +1,518 @@
+#include "optimal_solver.h"
+#include "cubie_cube.h"
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+OptimalSolver* optimalSolver = nullptr;
+
+namespace {
+
+const char TABLE_MAGIC[8] = {'R', 'C', 'O', 'P', 'T', 'P', 'D', 'B'};
+const uint32_t TABLE_VERSION = 3;
+
+// Depth of the subtrees handed out to the worker threads
+const int SPLIT_DEPTH = 3;
+
+const uint8_t UNVISITED = 0xFF;
+
+int threadCount(int requested) {
+    if (requested > 0) return requested;
+    unsigned cores = thread::hardware_concurrency();
+    return cores > 0 ? (int)cores : 1;
+}
+
+// Run body(begin, end) over [0, count) in chunks on all threads
+template <class Body>
+void parallelFor(size_t count, int threads, Body body) {
+    const size_t chunk = 1 << 16;
+    atomic<size_t> next(0);
+    auto run = [&]() {
+        for (;;) {
+            size_t begin = next.fetch_add(chunk);
+            if (begin >= count) break;
+            body(begin, min(count, begin + chunk));
+        }
+    };
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.push_back(thread(run));
+    }
+    run();
+    for (size_t t = 0; t < pool.size(); t++) {
+        pool[t].join();
+    }
+}
+
+bool isCancelled(const atomic<bool>* cancel) {
+    return cancel && cancel->load(memory_order_relaxed);
+}
+
+// Breadth-first fill of a pattern database. expand(index, out) writes the
+// 18 neighbours of an index. Levels go forwards from the frontier while it is
+// small and backwards from the unvisited entries once most are visited.
+// Each level is reported through progress (or printed without one); a
+// cancel is seen within one chunk and leaves the table half filled.
+template <class Expand>
+bool breadthFirstFill(vector<uint8_t>& table, size_t start, int threads, const char* name,
+                      const atomic<bool>* cancel, SolverProgress* progress, Expand expand) {
+    size_t size = table.size();
+    uint8_t* data = table.data();
+    memset(data, UNVISITED, size);
+    data[start] = 0;
+    size_t visited = 1;
+    if (progress) {
+        progress->building = name;
+        progress->depth = 0;
+        progress->nodes = visited;
+    }
+
+    for (int depth = 0; visited < size; depth++) {
+        bool backward = visited > size / 2;
+        parallelFor(size, threads, [&](size_t begin, size_t end) {
+            if (isCancelled(cancel)) return;
+            uint32_t neighbours[FACE_MOVE_COUNT];
+            for (size_t index = begin; index < end; index++) {
+                uint8_t value = __atomic_load_n(&data[index], __ATOMIC_RELAXED);
+                if (backward) {
+                    if (value != UNVISITED) continue;
+                    expand(index, neighbours);
+                    for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+                        if (__atomic_load_n(&data[neighbours[m]], __ATOMIC_RELAXED) == depth) {
+                            __atomic_store_n(&data[index], (uint8_t)(depth + 1), __ATOMIC_RELAXED);
+                            break;
+                        }
+                    }
+                } else {
+                    if (value != depth) continue;
+                    expand(index, neighbours);
+                    for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+                        if (__atomic_load_n(&data[neighbours[m]], __ATOMIC_RELAXED) == UNVISITED) {
+                            __atomic_store_n(&data[neighbours[m]], (uint8_t)(depth + 1), __ATOMIC_RELAXED);
+                        }
+                    }
+                }
+            }
+        });
+
+        if (isCancelled(cancel)) return false;
+
+        size_t added = 0;
+        for (size_t index = 0; index < size; index++) {
+            if (data[index] == depth + 1) added++;
+        }
+        if (added == 0) break;
+        visited += added;
+        if (progress) {
+            progress->depth = depth + 1;
+            progress->nodes = visited;
+        } else {
+            cout << "  " << name << " depth " << depth + 1 << ": " << added << " states" << endl;
+        }
+    }
+    return true;
+}
+
+// Index of the EDGE_GROUP edges in slots[] among the 12 positions, times their
+// orientations
+int edgeGroupIndex(const uint8_t* slots) {
+    int index = 0;
+    int orientation = 0;
+    unsigned used = 0;
+    for (int i = 0; i < OptimalSolver::EDGE_GROUP; i++) {
+        int position = slots[i] >> 1;
+        index = index * (12 - i) + position - __builtin_popcount(used & ((1u << position) - 1));
+        used |= 1u << position;
+        orientation = orientation * 2 + (slots[i] & 1);
+    }
+    return (index << OptimalSolver::EDGE_GROUP) + orientation;
+}
+
+void edgeGroupSlots(int index, uint8_t* slots) {
+    const int group = OptimalSolver::EDGE_GROUP;
+    int orientation = index & ((1 << group) - 1);
+    index >>= group;
+    int digit[group];
+    for (int i = group - 1; i >= 0; i--) {
+        digit[i] = index % (12 - i);
+        index /= 12 - i;
+    }
+    unsigned used = 0;
+    for (int i = 0; i < group; i++) {
+        int position = 0;
+        for (int skip = digit[i];; position++) {
+            if (used & (1u << position)) continue;
+            if (skip == 0) break;
+            skip--;
+        }
+        used |= 1u << position;
+        slots[i] = (uint8_t)(position * 2 + ((orientation >> (group - 1 - i)) & 1));
+    }
+}
+
+// Two distances per byte, the even index in the low half
+inline int packedEntry(const uint8_t* table, int index) {
+    return (table[index >> 1] >> ((index & 1) * 4)) & 0xF;
+}
+
+bool sameOrEarlierAxis(int face, int lastFace) {
+    // Never turn the same face twice in a row, and turn opposite faces in one order only
+    return lastFace >= 0 && (face == lastFace || (face % 3 == lastFace % 3 && face < lastFace));
+}
+
+} // namespace
+
+// One search thread: depth-first search below a fixed cost bound
+struct SearchWorker {
+    const OptimalSolver* solver;
+    int bound;
+    const atomic<bool>* found;
+    const atomic<bool>* cancel;
+    SolverProgress* progress;
+    unsigned long long nodes;
+    bool stopped;
+    uint8_t path[32];
+    int length;
+
+    SearchWorker(const OptimalSolver* s, int b, const atomic<bool>* f, const atomic<bool>* c, SolverProgress* p)
+        : solver(s), bound(b), found(f), cancel(c), progress(p), nodes(0), stopped(false), length(0) {}
+
+    bool checkpoint() {
+        if (progress) progress->nodes.fetch_add(0x1000, memory_order_relaxed);
+        return shouldStop();
+    }
+
+    bool shouldStop() const {
+        return found->load(memory_order_relaxed) || (cancel && cancel->load(memory_order_relaxed));
+    }
+
+    bool search(const OptimalSolver::Node& node, int depth, int lastFace) {
+        int remaining = bound - depth - 1;
+        OptimalSolver::Node child;
+        for (int face = 0; face < 6; face++) {
+            if (sameOrEarlierAxis(face, lastFace)) continue;
+            for (int power = 0; power < 3; power++) {
+                int move = face * 3 + power;
+                solver->applyMove(node, move, child);
+                if ((++nodes & 0xFFF) == 0 && checkpoint()) {
+                    stopped = true;
+                    return false;
+                }
+                int h = solver->heuristic(child, remaining);
+                if (h > remaining) continue;
+                path[depth] = (uint8_t)move;
+                if (h == 0) {
+                    length = depth + 1;
+                    return true;
+                }
+                if (search(child, depth + 1, face)) return true;
+                if (stopped) return false;
+            }
+        }
+        return false;
+    }
+};
+
+namespace {
+
+struct SearchTask {
+    OptimalSolver::Node node;
+    uint8_t path[SPLIT_DEPTH];
+    int lastFace;
+};
+
+// Per-thread task deque: the owner pops from the back, idle threads steal from the front
+struct TaskQueue {
+    mutex lock;
+    deque<SearchTask> tasks;
+
+    bool popBack(SearchTask& task) {
+        lock_guard<mutex> guard(lock);
+        if (tasks.empty()) return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+    bool stealFront(SearchTask& task) {
+        lock_guard<mutex> guard(lock);
+        if (tasks.empty()) return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+};
+
+} // namespace
+
+OptimalSolver::OptimalSolver() : ready(false), cornerPdb(nullptr) {
+    edgePdb[0] = nullptr;
+    edgePdb[1] = nullptr;
+}
+
+bool OptimalSolver::init(const string& tablePath, const atomic<bool>* cancel, SolverProgress* progress) {
+    if (ready) return true;
+    buildMoveTables();
+    if (!mapTables(tablePath)) {
+        if (!progress) cout << "Building optimal solver tables (one time)..." << endl;
+        bool built = buildPatternDatabases(cancel, progress);
+        if (progress) progress->building = nullptr;
+        if (!built) {
+            // Nothing half built is kept; the next init starts over
+            for (int i = 0; i < 3; i++) {
+                vector<uint8_t>().swap(builtTables[i]);
+            }
+            return false;
+        }
+        if (saveTables(tablePath)) {
+            cout << "\r\033[KSaved solver tables to " << tablePath << endl;
+        } else {
+            cout << "\r\033[KCould not write " << tablePath << ", tables will be rebuilt next time" << endl;
+        }
+    }
+    ready = true;
+    return true;
+}
+
+void OptimalSolver::buildMoveTables() {
+    cornerPermMove.resize(40320 * FACE_MOVE_COUNT);
+    twistMove.resize(2187 * FACE_MOVE_COUNT);
+
+    for (int i = 0; i < 40320; i++) {
+        for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+            CubieCube moved;
+            moved.setCornerPermutation(i);
+            moved.multiply(faceMoveCube(m));
+            cornerPermMove[i * FACE_MOVE_COUNT + m] = (uint16_t)moved.cornerPermutation();
+        }
+    }
+    for (int i = 0; i < 2187; i++) {
+        for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+            CubieCube moved;
+            moved.setTwist(i);
+            moved.multiply(faceMoveCube(m));
+            twistMove[i * FACE_MOVE_COUNT + m] = (uint16_t)moved.twist();
+        }
+    }
+
+    // Where an edge at (position, orientation) ends up after each move
+    for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+        const CubieCube& move = faceMoveCube(m);
+        for (int to = 0; to < 12; to++) {
+            int from = move.ep[to];
+            for (int ori = 0; ori < 2; ori++) {
+                edgeMove[from * 2 + ori][m] = (uint8_t)(to * 2 + (ori + move.eo[to]) % 2);
+            }
+        }
+    }
+}
+
+bool OptimalSolver::buildPatternDatabases(const atomic<bool>* cancel, SolverProgress* progress) {
+    int threads = threadCount(0);
+
+    builtTables[0].resize((size_t)CORNER_PDB_SIZE);
+    bool filled = breadthFirstFill(builtTables[0], 0, threads, "corners", cancel, progress,
+                                   [this](size_t index, uint32_t* out) {
+        int perm = (int)(index / 2187);
+        int tw = (int)(index % 2187);
+        for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+            out[m] = (uint32_t)cornerPermMove[perm * FACE_MOVE_COUNT + m] * 2187 + twistMove[tw * FACE_MOVE_COUNT + m];
+        }
+    });
+    if (!filled) return false;
+
+    // The edge databases are filled a byte per entry, then packed
+    vector<uint8_t> distances((size_t)EDGE_PDB_SIZE);
+    for (int group = 0; group < 2; group++) {
+        uint8_t solved[EDGE_GROUP];
+        for (int i = 0; i < EDGE_GROUP; i++) {
+            solved[i] = (uint8_t)((group * EDGE_SECOND + i) * 2);
+        }
+        filled = breadthFirstFill(distances, edgeGroupIndex(solved), threads, group == 0 ? "edges A" : "edges B",
+                                  cancel, progress, [this](size_t index, uint32_t* out) {
+            uint8_t slots[EDGE_GROUP];
+            uint8_t moved[EDGE_GROUP];
+            edgeGroupSlots((int)index, slots);
+            for (int m = 0; m < FACE_MOVE_COUNT; m++) {
+                for (int i = 0; i < EDGE_GROUP; i++) {
+                    moved[i] = edgeMove[slots[i]][m];
+                }
+                out[m] = (uint32_t)edgeGroupIndex(moved);
+            }
+        });
+        if (!filled) return false;
+        vector<uint8_t>& packed = builtTables[group + 1];
+        packed.resize((size_t)EDGE_PDB_SIZE / 2);
+        for (size_t i = 0; i < packed.size(); i++) {
+            packed[i] = (uint8_t)(distances[i * 2] | distances[i * 2 + 1] << 4);
+        }
+    }
+
+    cornerPdb = builtTables[0].data();
+    edgePdb[0] = builtTables[1].data();
+    edgePdb[1] = builtTables[2].data();
+    return true;
+}
+
+bool OptimalSolver::mapTables(const string& path) {
+    vector<size_t> sizes;
+    sizes.push_back((size_t)CORNER_PDB_SIZE);
+    sizes.push_back((size_t)EDGE_PDB_SIZE / 2);
+    sizes.push_back((size_t)EDGE_PDB_SIZE / 2);
+    if (!tableFile.map(path, TABLE_MAGIC, TABLE_VERSION, sizes)) return false;
+
+    cornerPdb = tableFile.section(0);
+    edgePdb[0] = tableFile.section(1);
+    edgePdb[1] = tableFile.section(2);
+    return true;
+}
+
+bool OptimalSolver::saveTables(const string& path) const {
+    vector<TableFile::Section> sections;
+    for (int i = 0; i < 3; i++) {
+        sections.push_back(TableFile::Section(builtTables[i].data(), builtTables[i].size()));
+    }
+    return TableFile::write(path, TABLE_MAGIC, TABLE_VERSION, sections);
+}
+
+void OptimalSolver::applyMove(const Node& node, int move, Node& result) const {
+    result.cornerPerm = cornerPermMove[node.cornerPerm * FACE_MOVE_COUNT + move];
+    result.twist = twistMove[node.twist * FACE_MOVE_COUNT + move];
+    for (int i = 0; i < 12; i++) {
+        result.edges[i] = edgeMove[node.edges[i]][move];
+    }
+}
+
+// Lower bound on the distance to solved; stops looking once it exceeds limit
+int OptimalSolver::heuristic(const Node& node, int limit) const {
+    int h = cornerPdb[(size_t)node.cornerPerm * 2187 + node.twist];
+    if (h > limit) return h;
+    int e = packedEntry(edgePdb[0], edgeGroupIndex(node.edges));
+    if (e > h) h = e;
+    if (h > limit) return h;
+    e = packedEntry(edgePdb[1], edgeGroupIndex(node.edges + EDGE_SECOND));
+    return e > h ? e : h;
+}
+
+bool OptimalSolver::solve(const CubeState& state, vector<int>& solution,
+                          const Options& options, Stats* stats) const {
+    solution.clear();
+    if (!ready) return false;
+
+    CubieCube cube;
+    if (!cube.fromState(state)) return false;
+
+    auto startTime = chrono::steady_clock::now();
+    Node root;
+    root.cornerPerm = (uint16_t)cube.cornerPermutation();
+    root.twist = (uint16_t)cube.twist();
+    for (int i = 0; i < 12; i++) {
+        root.edges[cube.ep[i]] = (uint8_t)(i * 2 + cube.eo[i]);
+    }
+
+    int threads = threadCount(options.threads);
+    atomic<bool> found(false);
+    atomic<unsigned long long> totalNodes(0);
+    mutex solutionLock;
+    uint8_t bestPath[32];
+    int bestLength = -1;
+
+    int h0 = heuristic(root, 255);
+    if (h0 == 0) bestLength = 0;
+
+    for (int bound = h0; bestLength < 0 && bound <= options.maxDepth; bound++) {
+        if (options.cancel && options.cancel->load()) break;
+        if (options.progress) options.progress->depth.store(bound, memory_order_relaxed);
+
+        if (bound <= SPLIT_DEPTH) {
+            // Shallow bounds are cheap, search them on this thread
+            SearchWorker worker(this, bound, &found, options.cancel, options.progress);
+            if (worker.search(root, 0, -1)) {
+                memcpy(bestPath, worker.path, worker.length);
+                bestLength = worker.length;
+            }
+            totalNodes += worker.nodes;
+        } else {
+            // Collect the pruned subtrees at SPLIT_DEPTH and deal them out
+            unique_ptr<TaskQueue[]> queues(new TaskQueue[threads]);
+            int taskCount = 0;
+            SearchTask task;
+            function<void(const Node&, int, int)> collect = [&](const Node& node, int depth, int lastFace) {
+                if (depth == SPLIT_DEPTH) {
+                    task.node = node;
+                    task.lastFace = lastFace;
+                    queues[taskCount++ % threads].tasks.push_back(task);
+                    return;
+                }
+                Node child;
+                for (int face = 0; face < 6; face++) {
+                    if (sameOrEarlierAxis(face, lastFace)) continue;
+                    for (int power = 0; power < 3; power++) {
+                        int move = face * 3 + power;
+                        applyMove(node, move, child);
+                        if (depth + 1 + heuristic(child, bound - depth - 1) > bound) continue;
+                        task.path[depth] = (uint8_t)move;
+                        collect(child, depth + 1, face);
+                    }
+                }
+            };
+            collect(root, 0, -1);
+
+            auto work = [&](int id) {
+                SearchWorker worker(this, bound, &found, options.cancel, options.progress);
+                SearchTask current;
+                for (;;) {
+                    if (worker.shouldStop()) break;
+                    bool haveTask = queues[id].popBack(current);
+                    for (int k = 1; !haveTask && k < threads; k++) {
+                        haveTask = queues[(id + k) % threads].stealFront(current);
+                    }
+                    if (!haveTask) break;
+
+                    memcpy(worker.path, current.path, SPLIT_DEPTH);
+                    if (worker.search(current.node, SPLIT_DEPTH, current.lastFace)) {
+                        lock_guard<mutex> guard(solutionLock);
+                        if (!found.load()) {
+                            memcpy(bestPath, worker.path, worker.length);
+                            bestLength = worker.length;
+                            found = true;
+                        }
+                    }
+                }
+                totalNodes += worker.nodes;
+            };
+
+            vector<thread> pool;
+            for (int t = 1; t < threads; t++) {
+                pool.push_back(thread(work, t));
+            }
+            work(0);
+            for (size_t t = 0; t < pool.size(); t++) {
+                pool[t].join();
+            }
+        }
+
+        if (bestLength < 0 && !(options.cancel && options.cancel->load()) && stats) {
+            stats->depth = bound;
+        }
+    }
+
+    if (stats) {
+        if (bestLength >= 0) stats->depth = bestLength;
+        stats->nodes = totalNodes;
+        stats->seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    }
+    if (bestLength < 0) return false;
+
+    for (int i = 0; i < bestLength; i++) {
+        solution.push_back(faceMoveToStateMove(bestPath[i]));
+    }
+    return true;
+}
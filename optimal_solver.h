@@ -0,0 +1,89 @@
+#ifndef OPTIMAL_SOLVER_H
+#define OPTIMAL_SOLVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cube_state.h"
+#include "solver_progress.h"
+#include "table_file.h"
+
+// Optimal solver: IDA* in the face turn metric with a corner pattern database
+// and two 7-edge pattern databases as the heuristic. The first levels of each
+// iteration are split into subtrees that all cores work through with work stealing.
+//
+// The pattern databases take a while to build, so they are written to a table
+// file after the first run and mapped from it afterwards.
+class OptimalSolver {
+public:
+    struct Options {
+        int threads;                    // 0 = one per core
+        int maxDepth;
+        const std::atomic<bool>* cancel; // optional, checked while searching
+        SolverProgress* progress;        // optional: the bound being searched and the node count
+
+        Options() : threads(0), maxDepth(20), cancel(nullptr), progress(nullptr) {}
+    };
+
+    struct Stats {
+        int depth;                      // deepest completed iteration
+        unsigned long long nodes;
+        double seconds;
+
+        Stats() : depth(0), nodes(0), seconds(0.0) {}
+    };
+
+    static const int CORNER_PDB_SIZE = 40320 * 2187;
+    // Each edge database covers 7 of the 12 edges, the first from UR and the
+    // second from DF, so the two share DF and DL
+    static const int EDGE_GROUP = 7;
+    static const int EDGE_SECOND = 12 - EDGE_GROUP;
+    static const int EDGE_PDB_SIZE = 3991680 * 128;
+
+    OptimalSolver();
+
+    // Load the pattern databases from tablePath, or build and save them. The
+    // build is reported through progress if given and can be cancelled, in
+    // which case nothing is saved and init returns false.
+    bool init(const std::string& tablePath, const std::atomic<bool>* cancel = nullptr,
+              SolverProgress* progress = nullptr);
+    bool isReady() const { return ready; }
+
+    // Solve the state; the solution is a list of CubeState moves (quarter and
+    // half turns of the outer layers). Returns false if cancelled, if no
+    // solution exists within maxDepth or if the state is not a valid cube.
+    bool solve(const CubeState& state, std::vector<int>& solution,
+               const Options& options = Options(), Stats* stats = nullptr) const;
+
+    struct Node {
+        uint16_t cornerPerm;
+        uint16_t twist;
+        uint8_t edges[12]; // position * 2 + orientation of every edge piece
+    };
+
+private:
+    bool ready;
+    std::vector<uint16_t> cornerPermMove; // [40320][18]
+    std::vector<uint16_t> twistMove;      // [2187][18]
+    uint8_t edgeMove[24][18];
+    const uint8_t* cornerPdb;
+    const uint8_t* edgePdb[2];            // edges UR..DL and DF..BR, 4 bits per entry
+    std::vector<uint8_t> builtTables[3];  // only used when the tables were built in this run
+    TableFile tableFile;
+
+    void buildMoveTables();
+    bool buildPatternDatabases(const std::atomic<bool>* cancel, SolverProgress* progress);
+    bool mapTables(const std::string& path);
+    bool saveTables(const std::string& path) const;
+
+    void applyMove(const Node& node, int move, Node& result) const;
+    int heuristic(const Node& node, int limit) const;
+
+    friend struct SearchWorker;
+};
+
+// Global optimal solver instance, created on first use
+extern OptimalSolver* optimalSolver;
+
+#endif
@@ -0,0 +1,154 @@
+#define GL_GLEXT_PROTOTYPES
+#include "shader_pipeline.h"
+#include <cmath>
+#include <cstdio>
+
+ShaderPipeline* shaderPipeline = nullptr;
+
+namespace {
+
+// Per-vertex lighting as initGL sets it up: the light is at (1, 1, 1, 0) in eye
+// space, ambient is the default global 0.2 plus the light's 0.3, diffuse 0.8.
+// The light direction arrives in world space so normals need no view transform.
+const char* vertexSource =
+    "#version 330 core\n"
+    "layout(location = 0) in vec3 position;\n"
+    "layout(location = 1) in vec3 normal;\n"
+    "layout(location = 2) in vec4 color;\n"
+    "uniform mat4 viewProjection;\n"
+    "uniform mat3 layerTurn;\n"
+    "uniform vec3 lightDirection;\n"
+    "out vec4 litColor;\n"
+    "void main() {\n"
+    "    gl_Position = viewProjection * vec4(layerTurn * position, 1.0);\n"
+    "    float diffuse = max(dot(layerTurn * normal, lightDirection), 0.0);\n"
+    "    litColor = vec4(color.rgb * (0.5 + 0.8 * diffuse), 1.0);\n"
+    "}\n";
+
+const char* fragmentSource =
+    "#version 330 core\n"
+    "in vec4 litColor;\n"
+    "out vec4 fragmentColor;\n"
+    "void main() {\n"
+    "    fragmentColor = litColor;\n"
+    "}\n";
+
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        fprintf(stderr, "Shader compile failed: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+GLuint ShaderPipeline::buildProgram(const char* vertex, const char* fragment) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertex);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragment);
+    if (!vertexShader || !fragmentShader) return 0;
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        fprintf(stderr, "Shader link failed: %s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ShaderPipeline::lightDirection(const Camera& camera, float* light) {
+    // Eye-space light (1, 1, 1) back to world space: the view rotation is
+    // orthonormal, so its transpose (the matrix rows) inverts it
+    const float* view = camera.getViewMatrix();
+    for (int a = 0; a < 3; a++) {
+        light[a] = (view[a * 4] + view[a * 4 + 1] + view[a * 4 + 2]) / std::sqrt(3.0f);
+    }
+}
+
+ShaderPipeline::ShaderPipeline()
+    : program(0), vertexArray(0), quadBuffer(0), viewProjectionLocation(-1), lightDirectionLocation(-1),
+      layerTurnLocation(-1), cameraChanges(0) {
+}
+
+ShaderPipeline::~ShaderPipeline() {
+    if (program) glDeleteProgram(program);
+    if (quadBuffer) glDeleteBuffers(1, &quadBuffer);
+    if (vertexArray) glDeleteVertexArrays(1, &vertexArray);
+}
+
+bool ShaderPipeline::init() {
+    program = buildProgram(vertexSource, fragmentSource);
+    if (!program) return false;
+    viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+    lightDirectionLocation = glGetUniformLocation(program, "lightDirection");
+    layerTurnLocation = glGetUniformLocation(program, "layerTurn");
+    glUseProgram(program);
+    setLayerTurn(0, 0.0f);
+
+    // Core profiles draw nothing without a vertex array object
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    glGenBuffers(1, &quadBuffer);
+    return true;
+}
+
+void ShaderPipeline::beginFrame(const Camera& camera) {
+    // Another program (the cube wall) may have drawn since the last frame
+    glUseProgram(program);
+    glBindVertexArray(vertexArray);
+    if (camera.getChanges() == cameraChanges) return;
+    cameraChanges = camera.getChanges();
+
+    glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, camera.getViewProjectionMatrix());
+    float light[3];
+    lightDirection(camera, light);
+    glUniform3fv(lightDirectionLocation, 1, light);
+}
+
+void ShaderPipeline::setLayerTurn(int axis, float angle) {
+    // Rotation about one coordinate axis, column-major
+    float radians = angle * (float)M_PI / 180.0f;
+    float c = std::cos(radians);
+    float s = std::sin(radians);
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    float rotation[9] = {0.0f};
+    rotation[axis * 3 + axis] = 1.0f;
+    rotation[u * 3 + u] = c;
+    rotation[u * 3 + v] = s;
+    rotation[v * 3 + u] = -s;
+    rotation[v * 3 + v] = c;
+    glUniformMatrix3fv(layerTurnLocation, 1, GL_FALSE, rotation);
+}
+
+void ShaderPipeline::drawQuad(const float* corners, const float* normal, const unsigned char* rgb) {
+    // Fresh storage each time, so the driver need not wait for the last cap's draw
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, 12 * sizeof(float), corners, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(POSITION);
+    glVertexAttribPointer(POSITION, 3, GL_FLOAT, GL_FALSE, 0, (const void*)0);
+    glVertexAttrib3fv(NORMAL, normal);
+    glVertexAttrib4f(COLOR, rgb[0] / 255.0f, rgb[1] / 255.0f, rgb[2] / 255.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glDisableVertexAttribArray(POSITION);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
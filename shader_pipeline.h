@@ -0,0 +1,61 @@
+#ifndef SHADER_PIPELINE_H
+#define SHADER_PIPELINE_H
+
+#include <GL/glut.h>
+#include "camera.h"
+
+// Optional GL 3.3 core-profile drawing path (--core), replacing fixed-function
+// lighting, client arrays and the matrix stack.
+//
+// The view-projection matrix comes from the Camera's cached matrices and is
+// uploaded only when the camera changed. Lighting matches the fixed-function
+// setup of initGL (one directional light, colour material, no specular) and
+// runs per vertex in the shader. The turning layer is rotated in the shader
+// by one uniform rotation matrix. Faces and edge lines share one program;
+// lines are lit too, which leaves black black.
+class ShaderPipeline {
+public:
+    // Vertex attribute locations
+    static const GLuint POSITION = 0;
+    static const GLuint NORMAL = 1;
+    static const GLuint COLOR = 2;
+
+    ShaderPipeline();
+    ~ShaderPipeline();
+
+    // Compile the program and make it current; needs a current 3.3 context.
+    // Prints why on failure.
+    bool init();
+
+    // Start a frame: make the program current and upload the camera matrices
+    // if the camera changed
+    void beginFrame(const Camera& camera);
+
+    // Rotation of what is drawn next about the cube centre, in degrees
+    // (glRotatef convention); 0 for the still cubies
+    void setLayerTurn(int axis, float angle);
+
+    // One lit quad (corners in fan order) in a constant colour, e.g. an interior cap
+    void drawQuad(const float* corners, const float* normal, const unsigned char* rgb);
+
+    // Compile and link a vertex and fragment shader; 0 (and the log on
+    // stderr) on failure
+    static GLuint buildProgram(const char* vertexSource, const char* fragmentSource);
+
+    // World-space direction of the initGL light as seen from this camera
+    static void lightDirection(const Camera& camera, float* light);
+
+private:
+    GLuint program;
+    GLuint vertexArray;
+    GLuint quadBuffer;
+    GLint viewProjectionLocation;
+    GLint lightDirectionLocation;
+    GLint layerTurnLocation;
+    unsigned cameraChanges;
+};
+
+// Set when running in a core-profile context, otherwise null
+extern ShaderPipeline* shaderPipeline;
+
+#endif
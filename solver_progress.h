@@ -0,0 +1,20 @@
+#ifndef SOLVER_PROGRESS_H
+#define SOLVER_PROGRESS_H
+
+#include <atomic>
+
+// Live figures of a running solve, written by the search threads with relaxed
+// stores and readable from any thread. Nodes are added in blocks of 4096, at
+// the points where the searches already check for cancellation.
+//
+// While a solver builds its tables on first use, building names the table and
+// depth and nodes are its breadth-first level and the states reached so far.
+struct SolverProgress {
+    std::atomic<int> depth;                 // search depth being tried
+    std::atomic<unsigned long long> nodes;  // nodes expanded so far
+    std::atomic<const char*> building;      // table being built, or null
+
+    SolverProgress() : depth(0), nodes(0), building(nullptr) {}
+};
+
+#endif
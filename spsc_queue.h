@@ -0,0 +1,52 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. A ring of CAPACITY slots (a power of two) with free-running head
+// and tail counters: the producer only writes tail, the consumer only writes
+// head, and the release store of each publishes the slot it covers, so
+// neither side ever waits on the other. The counters are padded 64 bytes
+// apart so the two threads do not bounce one cache line between them.
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // Producer: false if the queue is full
+    bool push(const T& value) {
+        size_t back = tail.load(std::memory_order_relaxed);
+        if (back - head.load(std::memory_order_acquire) == CAPACITY) return false;
+        slots[back & (CAPACITY - 1)] = value;
+        tail.store(back + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false if the queue is empty
+    bool pop(T& value) {
+        size_t front = head.load(std::memory_order_relaxed);
+        if (front == tail.load(std::memory_order_acquire)) return false;
+        value = slots[front & (CAPACITY - 1)];
+        head.store(front + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only while neither side is using the queue
+    void clear() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<size_t> head;  // next slot to read
+    char headPadding[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail;  // next slot to write
+    char tailPadding[64 - sizeof(std::atomic<size_t>)];
+    T slots[CAPACITY];
+};
+
+#endif
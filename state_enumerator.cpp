@@ -0,0 +1,505 @@
+#include "state_enumerator.h"
+#include "cube_state.h"
+#include "cubie_cube.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// Corner the 2x2 holds in place (only U, R and F turns keep it there)
+const int FIXED_CORNER = DBL;
+
+// A subgroup with a dense index = permutation coordinate * twistCount + twist
+struct Space {
+    string name;
+    int permCount;
+    int twistCount;
+    vector<int> faceMoves;       // generators as solver face moves
+    vector<uint16_t> permMove;   // [perm * moves + m]
+    vector<uint16_t> twistMove;  // [twist * moves + m]
+
+    int moveCount() const { return (int)faceMoves.size(); }
+    uint64_t size() const { return (uint64_t)permCount * twistCount; }
+
+    uint32_t next(uint32_t index, int m) const {
+        uint32_t perm = index / twistCount;
+        uint32_t twist = index % twistCount;
+        int moves = moveCount();
+        return (uint32_t)permMove[perm * moves + m] * twistCount + twistMove[twist * moves + m];
+    }
+};
+
+// Corner coordinates of either space
+int encodePerm(const Space& space, const CubieCube& cube) {
+    if (space.permCount == 40320) return cube.cornerPermutation();
+    // 2x2: rank the other seven corners, DRB taking the place of the fixed slot
+    uint8_t perm[7];
+    int k = 0;
+    for (int i = 0; i < 8; i++) {
+        if (i == FIXED_CORNER) continue;
+        perm[k++] = cube.cp[i] == 7 ? FIXED_CORNER : cube.cp[i];
+    }
+    return rankPermutation(perm, 7);
+}
+
+void decodePerm(const Space& space, int index, CubieCube& cube) {
+    if (space.permCount == 40320) {
+        cube.setCornerPermutation(index);
+        return;
+    }
+    uint8_t perm[7];
+    unrankPermutation(index, perm, 7);
+    int k = 0;
+    for (int i = 0; i < 8; i++) {
+        if (i == FIXED_CORNER) {
+            cube.cp[i] = FIXED_CORNER;
+            continue;
+        }
+        cube.cp[i] = perm[k] == FIXED_CORNER ? 7 : perm[k];
+        k++;
+    }
+}
+
+int encodeTwist(const Space& space, const CubieCube& cube) {
+    if (space.twistCount == 2187) return cube.twist();
+    // 2x2: the first six corners; DBL never twists and DRB follows from the rest
+    int result = 0;
+    for (int i = 0; i < 6; i++) {
+        result = result * 3 + cube.co[i];
+    }
+    return result;
+}
+
+void decodeTwist(const Space& space, int index, CubieCube& cube) {
+    if (space.twistCount == 2187) {
+        cube.setTwist(index);
+        return;
+    }
+    int sum = 0;
+    for (int i = 5; i >= 0; i--) {
+        cube.co[i] = (uint8_t)(index % 3);
+        sum += cube.co[i];
+        index /= 3;
+    }
+    cube.co[FIXED_CORNER] = 0;
+    cube.co[7] = (uint8_t)((3 - sum % 3) % 3);
+}
+
+void buildMoveTables(Space& space) {
+    int moves = space.moveCount();
+    space.permMove.resize((size_t)space.permCount * moves);
+    space.twistMove.resize((size_t)space.twistCount * moves);
+    for (int p = 0; p < space.permCount; p++) {
+        CubieCube cube;
+        decodePerm(space, p, cube);
+        for (int m = 0; m < moves; m++) {
+            CubieCube moved = cube;
+            moved.multiply(faceMoveCube(space.faceMoves[m]));
+            space.permMove[p * moves + m] = (uint16_t)encodePerm(space, moved);
+        }
+    }
+    for (int t = 0; t < space.twistCount; t++) {
+        CubieCube cube;
+        decodeTwist(space, t, cube);
+        for (int m = 0; m < moves; m++) {
+            CubieCube moved = cube;
+            moved.multiply(faceMoveCube(space.faceMoves[m]));
+            space.twistMove[t * moves + m] = (uint16_t)encodeTwist(space, moved);
+        }
+    }
+}
+
+// Generators from keyboard letters. Returns false with a message on stderr.
+bool parseGenerators(Space& space, const string& letters, bool quarter) {
+    const char* text = letters.c_str();
+    const char* end = text + letters.size();
+    bool used[6] = {false};
+    for (;;) {
+        int move = CubeState::parseMove(text, end);
+        if (move < 0) {
+            if (text < end) {
+                fprintf(stderr, "Bad move list at \"%s\"\n", text);
+                return false;
+            }
+            break;
+        }
+
+        int face = -1;
+        for (int f = 0; f < 6; f++) {
+            if (CubeState::moveLayer(faceMoveToStateMove(f * 3)) == CubeState::moveLayer(move)) face = f;
+        }
+        if (face < 0) {
+            fprintf(stderr, "%s is a slice, it does not move corners\n", CubeState::moveName(move));
+            return false;
+        }
+        if (space.permCount == 5040 && faceMoveCube(face * 3).cp[FIXED_CORNER] != FIXED_CORNER) {
+            fprintf(stderr, "%s moves the fixed corner of the 2x2, use U X F\n", CubeState::moveName(move));
+            return false;
+        }
+        used[face] = true;
+    }
+
+    for (int face = 0; face < 6; face++) {
+        if (!used[face]) continue;
+        for (int power = 0; power < 3; power++) {
+            if (quarter && power == 1) continue;
+            space.faceMoves.push_back(face * 3 + power);
+        }
+    }
+    if (space.faceMoves.empty()) {
+        fprintf(stderr, "No generators\n");
+        return false;
+    }
+    return true;
+}
+
+// Bitset in a file, shared read-write mapping
+class MappedBitset {
+private:
+    uint64_t* words;
+    size_t wordCount;
+
+public:
+    MappedBitset() : words(nullptr), wordCount(0) {}
+    ~MappedBitset() {
+        if (words) munmap(words, wordCount * sizeof(uint64_t));
+    }
+
+    bool open(const string& path, uint64_t bits) {
+        wordCount = (size_t)((bits + 63) / 64);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        // A new file is extended with zeros; an existing one keeps its bits
+        if (ftruncate(fd, (off_t)(wordCount * sizeof(uint64_t))) != 0) {
+            close(fd);
+            return false;
+        }
+        void* data = mmap(nullptr, wordCount * sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return false;
+        words = (uint64_t*)data;
+        return true;
+    }
+
+    bool test(uint32_t index) const {
+        return (words[index / 64] >> (index % 64)) & 1;
+    }
+
+    // Set the bit from any thread; true if this call set it
+    bool testAndSet(uint32_t index) {
+        uint64_t bit = 1ULL << (index % 64);
+        return (__atomic_fetch_or(&words[index / 64], bit, __ATOMIC_RELAXED) & bit) == 0;
+    }
+
+    void merge(const MappedBitset& other) {
+        for (size_t i = 0; i < wordCount; i++) {
+            words[i] |= other.words[i];
+        }
+    }
+
+    void clear() { memset(words, 0, wordCount * sizeof(uint64_t)); }
+    bool sync() { return msync(words, wordCount * sizeof(uint64_t), MS_SYNC) == 0; }
+};
+
+// Committed state of a run, kept in <dir>/progress. A depth is "expanded" once
+// all its frontier chunks are on disk and "committed" once its states are
+// merged into the visited set and the previous frontier is gone.
+struct Progress {
+    string space;
+    string generators;
+    int depth;
+    string phase;  // committed, expanded or done
+    vector<uint64_t> counts;
+};
+
+bool writeProgress(const string& dir, const Progress& progress) {
+    string path = dir + "/progress";
+    string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "w");
+    if (!file) return false;
+    fprintf(file, "space %s\ngenerators %s\ndepth %d %s\n",
+            progress.space.c_str(), progress.generators.c_str(), progress.depth, progress.phase.c_str());
+    for (size_t d = 0; d < progress.counts.size(); d++) {
+        fprintf(file, "count %zu %llu\n", d, (unsigned long long)progress.counts[d]);
+    }
+    bool ok = fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    return ok && rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool readProgress(const string& dir, Progress& progress) {
+    FILE* file = fopen((dir + "/progress").c_str(), "r");
+    if (!file) return false;
+    char space[64], generators[128], phase[32];
+    bool ok = fscanf(file, "space %63s\ngenerators %127s\ndepth %d %31s\n",
+                     space, generators, &progress.depth, phase) == 4;
+    progress.space = space;
+    progress.generators = generators;
+    progress.phase = phase;
+    progress.counts.clear();
+    size_t d;
+    unsigned long long count;
+    while (ok && fscanf(file, "count %zu %llu\n", &d, &count) == 2) {
+        progress.counts.push_back(count);
+    }
+    fclose(file);
+    return ok;
+}
+
+string chunkPrefix(int depth) {
+    return "frontier-" + to_string(depth) + "-";
+}
+
+vector<string> listChunks(const string& dir, int depth) {
+    vector<string> chunks;
+    string prefix = chunkPrefix(depth);
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) return chunks;
+    while (dirent* entry = readdir(handle)) {
+        if (strncmp(entry->d_name, prefix.c_str(), prefix.size()) == 0) {
+            chunks.push_back(dir + "/" + entry->d_name);
+        }
+    }
+    closedir(handle);
+    sort(chunks.begin(), chunks.end());
+    return chunks;
+}
+
+void removeChunks(const string& dir, int depth) {
+    vector<string> chunks = listChunks(dir, depth);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        unlink(chunks[i].c_str());
+    }
+}
+
+bool writeChunk(const string& path, vector<uint32_t>& states) {
+    sort(states.begin(), states.end());
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(states.data(), sizeof(uint32_t), states.size(), file) == states.size();
+    ok = fflush(file) == 0 && fsync(fileno(file)) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+bool readChunk(const string& path, vector<uint32_t>& states) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    fseek(file, 0, SEEK_END);
+    long bytes = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    states.resize(bytes / sizeof(uint32_t));
+    bool ok = fread(states.data(), sizeof(uint32_t), states.size(), file) == states.size();
+    fclose(file);
+    return ok;
+}
+
+// Expand every chunk of depth into chunks of depth + 1. New states are those
+// in neither visited nor next; next marks them so each is written once.
+bool expandDepth(const string& dir, int depth, const Space& space, const MappedBitset& visited,
+                 MappedBitset& next, int threads, size_t chunkStates, uint64_t& found) {
+    vector<string> inputs = listChunks(dir, depth);
+    atomic<size_t> nextInput(0);
+    atomic<uint64_t> total(0);
+    atomic<bool> failed(false);
+
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&, t]() {
+            vector<uint32_t> states;
+            vector<uint32_t> output;
+            output.reserve(chunkStates);
+            int written = 0;
+            uint64_t count = 0;
+            auto flush = [&]() {
+                if (output.empty()) return;
+                char name[64];
+                snprintf(name, sizeof(name), "%s%03d-%06d.bin", chunkPrefix(depth + 1).c_str(), t, written++);
+                if (!writeChunk(dir + "/" + name, output)) failed = true;
+                output.clear();
+            };
+
+            for (size_t i = nextInput++; i < inputs.size() && !failed; i = nextInput++) {
+                if (!readChunk(inputs[i], states)) {
+                    failed = true;
+                    break;
+                }
+                for (size_t s = 0; s < states.size(); s++) {
+                    for (int m = 0; m < space.moveCount(); m++) {
+                        uint32_t neighbour = space.next(states[s], m);
+                        if (visited.test(neighbour) || !next.testAndSet(neighbour)) continue;
+                        output.push_back(neighbour);
+                        count++;
+                        if (output.size() >= chunkStates) flush();
+                    }
+                }
+            }
+            flush();
+            total += count;
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    found = total;
+    return !failed;
+}
+
+string generatorNames(const Space& space) {
+    string names;
+    for (size_t i = 0; i < space.faceMoves.size(); i++) {
+        if (!names.empty()) names += ",";
+        names += CubeState::moveName(faceMoveToStateMove(space.faceMoves[i]));
+    }
+    return names;
+}
+
+} // namespace
+
+int runEnumeration(int argc, char** argv) {
+    Space space;
+    string moves;
+    string dir;
+    bool quarter = false;
+    int threads = 0;
+    size_t chunkStates = 1 << 20;
+    int maxDepth = -1;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--moves") == 0 && i + 1 < argc) {
+            moves = argv[++i];
+        } else if (strcmp(argv[i], "--quarter") == 0) {
+            quarter = true;
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+            chunkStates = (size_t)strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--max-depth") == 0 && i + 1 < argc) {
+            maxDepth = atoi(argv[++i]);
+        } else {
+            space.name = argv[i];
+        }
+    }
+
+    if (space.name == "corners") {
+        space.permCount = 40320;
+        space.twistCount = 2187;
+        if (moves.empty()) moves = "U D L X F B";
+    } else if (space.name == "2x2") {
+        space.permCount = 5040;
+        space.twistCount = 729;
+        if (moves.empty()) moves = "U X F";
+    } else {
+        fprintf(stderr, "Usage: rubiks_cube --enumerate corners|2x2 [--moves \"U X F\"] [--quarter]\n"
+                        "                   [--dir workdir] [--threads N] [--chunk states] [--max-depth D]\n");
+        return 1;
+    }
+    if (!parseGenerators(space, moves, quarter)) return 1;
+    if (chunkStates == 0) chunkStates = 1;
+    if (threads <= 0) {
+        threads = (int)thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+    }
+    if (dir.empty()) dir = "enumerate-" + space.name;
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s\n", dir.c_str());
+        return 1;
+    }
+
+    buildMoveTables(space);
+    MappedBitset visited;
+    MappedBitset next;
+    if (!visited.open(dir + "/visited.bits", space.size()) || !next.open(dir + "/next.bits", space.size())) {
+        fprintf(stderr, "Cannot map the bitsets in %s\n", dir.c_str());
+        return 1;
+    }
+
+    Progress progress;
+    if (readProgress(dir, progress)) {
+        if (progress.space != space.name || progress.generators != generatorNames(space)) {
+            fprintf(stderr, "%s holds a %s run with generators %s\n",
+                    dir.c_str(), progress.space.c_str(), progress.generators.c_str());
+            return 1;
+        }
+        fprintf(stderr, "Resuming %s at depth %d (%s)\n", dir.c_str(), progress.depth, progress.phase.c_str());
+    } else {
+        // Depth 0 is the solved state, index 0 in both spaces
+        progress.space = space.name;
+        progress.generators = generatorNames(space);
+        progress.depth = 0;
+        progress.phase = "committed";
+        progress.counts.assign(1, 1);
+        visited.clear();
+        next.clear();
+        visited.testAndSet(0);
+        vector<uint32_t> solved(1, 0);
+        if (!visited.sync() || !writeChunk(dir + "/" + chunkPrefix(0) + "000-000000.bin", solved) ||
+            !writeProgress(dir, progress)) {
+            fprintf(stderr, "Cannot write to %s\n", dir.c_str());
+            return 1;
+        }
+    }
+
+    while (progress.phase != "done" && (maxDepth < 0 || progress.depth < maxDepth || progress.phase == "expanded")) {
+        if (progress.phase == "committed") {
+            // Anything of depth + 1 is left over from an interrupted expansion
+            auto start = chrono::steady_clock::now();
+            removeChunks(dir, progress.depth + 1);
+            next.clear();
+            uint64_t found = 0;
+            if (!expandDepth(dir, progress.depth, space, visited, next, threads, chunkStates, found) || !next.sync()) {
+                fprintf(stderr, "Cannot write frontier %d in %s\n", progress.depth + 1, dir.c_str());
+                return 1;
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (found == 0) {
+                removeChunks(dir, progress.depth);
+                progress.phase = "done";
+            } else {
+                fprintf(stderr, "depth %d: %llu states (%.2f s)\n", progress.depth + 1, (unsigned long long)found, seconds);
+                progress.depth++;
+                progress.counts.push_back(found);
+                progress.phase = "expanded";
+            }
+        } else {
+            // Merging is idempotent, so this also finishes an interrupted merge
+            visited.merge(next);
+            if (!visited.sync()) {
+                fprintf(stderr, "Cannot sync %s/visited.bits\n", dir.c_str());
+                return 1;
+            }
+            removeChunks(dir, progress.depth - 1);
+            progress.phase = "committed";
+        }
+        if (!writeProgress(dir, progress)) {
+            fprintf(stderr, "Cannot write %s/progress\n", dir.c_str());
+            return 1;
+        }
+    }
+
+    uint64_t total = 0;
+    printf("%s <%s>\n", space.name.c_str(), progress.generators.c_str());
+    for (size_t d = 0; d < progress.counts.size(); d++) {
+        printf("%3zu %12llu\n", d, (unsigned long long)progress.counts[d]);
+        total += progress.counts[d];
+    }
+    printf("total %llu of %llu%s\n", (unsigned long long)total, (unsigned long long)space.size(),
+           progress.phase == "done" ? "" : " (incomplete)");
+    return 0;
+}
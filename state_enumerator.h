@@ -0,0 +1,24 @@
+#ifndef STATE_ENUMERATOR_H
+#define STATE_ENUMERATOR_H
+
+// Breadth-first enumeration of a cube subgroup, printing how many states lie
+// at each depth from solved. Spaces:
+//
+//   corners  the 8 corners of a 3x3 (88,179,840 states)
+//   2x2      the 2x2 cube, DBL corner held fixed (3,674,160 states)
+//
+// Each state has a dense index (corner permutation * twist count + twist), so
+// the visited set is a memory-mapped bitset on disk. The frontier of each
+// depth is streamed through sorted chunk files of state indices, expanded by a
+// pool of threads, so memory stays at a few chunks per thread whatever the
+// space size. Progress is committed to the work directory after every depth;
+// running the same command again after an interruption resumes from there.
+//
+// Generators are the keyboard outer layers (U D L X F B; the 2x2 only turns
+// U X F), with half turns unless --quarter is given.
+//
+// Usage: rubiks_cube --enumerate corners|2x2 [--moves "U X F"] [--quarter]
+//                    [--dir workdir] [--threads N] [--chunk states] [--max-depth D]
+int runEnumeration(int argc, char** argv);
+
+#endif
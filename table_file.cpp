@@ -0,0 +1,132 @@
+#include "table_file.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t SECTION_ALIGNMENT = 64;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+};
+
+size_t alignUp(size_t value) {
+    return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+size_t headerBytes(size_t sectionCount) {
+    return alignUp(sizeof(FileHeader) + sectionCount * sizeof(uint64_t));
+}
+
+} // namespace
+
+const size_t TableFile::ANY_SIZE;
+
+TableFile::TableFile() : mapping(nullptr), mappingSize(0) {
+}
+
+TableFile::~TableFile() {
+    unmap();
+}
+
+bool TableFile::map(const std::string& path, const char* magic, uint32_t version,
+                    const std::vector<size_t>& expectedSizes) {
+    unmap();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < headerBytes(expectedSizes.size())) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    // Check the header and that every section is where it should be
+    const uint8_t* bytes = (const uint8_t*)data;
+    FileHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    bool ok = memcmp(header.magic, magic, 8) == 0 &&
+              header.version == version &&
+              header.sectionCount == expectedSizes.size();
+
+    size_t offset = headerBytes(expectedSizes.size());
+    for (size_t i = 0; ok && i < expectedSizes.size(); i++) {
+        uint64_t sectionSize;
+        memcpy(&sectionSize, bytes + sizeof(FileHeader) + i * sizeof(uint64_t), sizeof(sectionSize));
+        bool sizeOk = expectedSizes[i] == ANY_SIZE || sectionSize == expectedSizes[i];
+        // Compared as the room left so a huge size cannot wrap the sum
+        if (!sizeOk || offset > size || sectionSize > size - offset) {
+            ok = false;
+            break;
+        }
+        sections.push_back(bytes + offset);
+        sectionSizes.push_back((size_t)sectionSize);
+        offset = alignUp(offset + sectionSize);
+    }
+
+    if (!ok) {
+        munmap(data, size);
+        sections.clear();
+        sectionSizes.clear();
+        return false;
+    }
+
+    mapping = data;
+    mappingSize = size;
+    return true;
+}
+
+void TableFile::unmap() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+    sections.clear();
+    sectionSizes.clear();
+}
+
+bool TableFile::write(const std::string& path, const char* magic, uint32_t version,
+                      const std::vector<Section>& sections) {
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+
+    std::vector<uint8_t> header(headerBytes(sections.size()), 0);
+    FileHeader fileHeader;
+    memcpy(fileHeader.magic, magic, 8);
+    fileHeader.version = version;
+    fileHeader.sectionCount = (uint32_t)sections.size();
+    memcpy(header.data(), &fileHeader, sizeof(fileHeader));
+    for (size_t i = 0; i < sections.size(); i++) {
+        uint64_t sectionSize = sections[i].size;
+        memcpy(header.data() + sizeof(FileHeader) + i * sizeof(uint64_t), &sectionSize, sizeof(sectionSize));
+    }
+
+    bool ok = fwrite(header.data(), 1, header.size(), file) == header.size();
+    static const uint8_t padding[SECTION_ALIGNMENT] = {0};
+    for (size_t i = 0; ok && i < sections.size(); i++) {
+        ok = fwrite(sections[i].data, 1, sections[i].size, file) == sections[i].size;
+        size_t pad = alignUp(sections[i].size) - sections[i].size;
+        if (ok && pad > 0) {
+            ok = fwrite(padding, 1, pad, file) == pad;
+        }
+    }
+
+    if (fclose(file) != 0) ok = false;
+    if (ok) ok = rename(tempPath.c_str(), path.c_str()) == 0;
+    if (!ok) remove(tempPath.c_str());
+    return ok;
+}
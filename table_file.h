@@ -0,0 +1,49 @@
+#ifndef TABLE_FILE_H
+#define TABLE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Versioned binary file of precomputed solver tables, mapped read-only with mmap.
+//
+// Layout: 8-byte magic, version, section count, the size of every section,
+// then the sections themselves, each starting on a 64-byte boundary.
+class TableFile {
+private:
+    void* mapping;
+    size_t mappingSize;
+    std::vector<const uint8_t*> sections;
+    std::vector<size_t> sectionSizes;
+
+public:
+    struct Section {
+        const void* data;
+        size_t size;
+
+        Section(const void* d, size_t s) : data(d), size(s) {}
+    };
+
+    // Expected size of a section whose size is only known from the file
+    static const size_t ANY_SIZE = (size_t)-1;
+
+    TableFile();
+    ~TableFile();
+
+    // Map path if it has the given magic and version and its sections have
+    // exactly the expected sizes (or any size where ANY_SIZE is expected)
+    bool map(const std::string& path, const char* magic, uint32_t version,
+             const std::vector<size_t>& expectedSizes);
+    void unmap();
+    bool isMapped() const { return mapping != nullptr; }
+
+    const uint8_t* section(size_t index) const { return sections[index]; }
+    size_t sectionSize(size_t index) const { return sectionSizes[index]; }
+
+    // Write the sections to path (via a temporary file and rename)
+    static bool write(const std::string& path, const char* magic, uint32_t version,
+                      const std::vector<Section>& sections);
+};
+
+#endif
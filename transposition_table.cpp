@@ -0,0 +1,64 @@
+#include "transposition_table.h"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+void TranspositionTable::FreeBuckets::operator()(Bucket* buckets) const {
+    free(buckets);
+}
+
+TranspositionTable::TranspositionTable(size_t capacity) {
+    size_t count = 1;
+    while (count * BUCKET_ENTRIES < capacity) count *= 2;
+    bucketMask = count - 1;
+    void* memory = nullptr;
+    if (posix_memalign(&memory, sizeof(Bucket), count * sizeof(Bucket)) != 0) throw bad_alloc();
+    buckets.reset(static_cast<Bucket*>(memory));
+    clear();
+}
+
+bool TranspositionTable::probe(uint64_t key, uint64_t& value) const {
+    const Entry* slots = bucket(key);
+    for (int i = 0; i < BUCKET_ENTRIES; i++) {
+        uint64_t v = slots[i].value.load(memory_order_relaxed);
+        uint64_t check = slots[i].check.load(memory_order_relaxed);
+        if ((check ^ v) == key && (check | v) != 0) {
+            value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, uint64_t value) {
+    Entry* slots = bucket(key);
+
+    // Overwrite the same key or an empty entry, otherwise the least valuable one
+    int victim = 0;
+    uint64_t victimValue = ~0ULL;
+    for (int i = 0; i < BUCKET_ENTRIES; i++) {
+        uint64_t v = slots[i].value.load(memory_order_relaxed);
+        uint64_t check = slots[i].check.load(memory_order_relaxed);
+        if ((check ^ v) == key || (check | v) == 0) {
+            victim = i;
+            break;
+        }
+        if (v < victimValue) {
+            victim = i;
+            victimValue = v;
+        }
+    }
+
+    slots[victim].check.store(key ^ value, memory_order_relaxed);
+    slots[victim].value.store(value, memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (size_t b = 0; b <= bucketMask; b++) {
+        for (int i = 0; i < BUCKET_ENTRIES; i++) {
+            buckets[b].slots[i].check.store(0, memory_order_relaxed);
+            buckets[b].slots[i].value.store(0, memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Fixed-size, lock-free hash table from 64-bit state hashes (CubeState::hash)
+// to 64-bit values, safe to probe and store from any number of threads.
+//
+// Entries sit in buckets of four that fill and align to one 64-byte cache
+// line, so a probe touches a single line. Each entry stores key ^ value next
+// to the value, so a torn read of an entry being overwritten by another
+// thread fails the key check instead of returning a wrong value. When a bucket
+// is full the entry with the smallest value is replaced, so callers that pack
+// a depth or priority into the high bits keep the most valuable results.
+// Key 0 with value 0 reads as an empty entry.
+class TranspositionTable {
+private:
+    struct Entry {
+        std::atomic<uint64_t> check;  // key ^ value
+        std::atomic<uint64_t> value;
+    };
+
+    static const int BUCKET_ENTRIES = 4;
+
+    struct alignas(64) Bucket {
+        Entry slots[BUCKET_ENTRIES];
+    };
+    static_assert(sizeof(Bucket) == 64, "a bucket must fill one cache line");
+
+    // new does not honour alignas before C++17, so buckets come from posix_memalign
+    struct FreeBuckets {
+        void operator()(Bucket* buckets) const;
+    };
+
+    std::unique_ptr<Bucket[], FreeBuckets> buckets;
+    size_t bucketMask;
+
+    Entry* bucket(uint64_t key) const { return buckets[key & bucketMask].slots; }
+
+public:
+    // Room for at least capacity entries (rounded up to a power of two buckets)
+    explicit TranspositionTable(size_t capacity);
+
+    size_t capacity() const { return (bucketMask + 1) * BUCKET_ENTRIES; }
+
+    bool probe(uint64_t key, uint64_t& value) const;
+    void store(uint64_t key, uint64_t value);
+
+    // Not safe while other threads use the table
+    void clear();
+};
+
+#endif